@@ -0,0 +1,42 @@
+#ifndef CCS811_BENCH_H
+#define CCS811_BENCH_H
+
+/**
+ * Minimal self-registering benchmark harness.
+ * BENCHMARK(name) defines a benchmark that times its own loop with bench_now_s() and reports with bench_report().
+ */
+
+#include <stdint.h>
+
+typedef void (*bench_fn_t)();
+
+typedef struct bench_case {
+    const char* name;
+    bench_fn_t function;
+    struct bench_case* next;
+} bench_case_t;
+
+void bench_register(bench_case_t* bench);
+double bench_now_s();
+void bench_report(const char* label, uint64_t operations, double seconds);
+void bench_note(const char* format, ...);
+
+struct bench_registrar {
+    bench_case_t bench;
+    bench_registrar(const char* name, bench_fn_t function) : bench{name, function, nullptr} { bench_register(&bench); }
+};
+
+#define BENCHMARK(name)                                    \
+    static void name();                                    \
+    static bench_registrar name##_registrar(#name, name);  \
+    static void name()
+
+/**
+ * Keep a computed value alive so the loop producing it is not optimised away.
+ */
+template <typename T>
+inline void bench_keep(const T& value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+#endif
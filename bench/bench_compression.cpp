@@ -0,0 +1,51 @@
+#include "CCS811_compression.h"
+#include "bench.h"
+
+/**
+ * Sample stream encoding and decoding throughput, and encoded size against fixed 8-byte records, on a day of jittered
+ * 1 s samples.
+ */
+
+static const uint32_t SAMPLES = 86400;
+static const uint32_t PASSES = 50;
+
+static ccs811_sample_t samples[SAMPLES];
+static uint8_t buffer[SAMPLES * CCS811_MAX_ENCODED_SAMPLE_SIZE];
+
+BENCHMARK(sample_compression) {
+    uint32_t random = 1;
+    uint32_t time_ms = 0;
+    int32_t eCO2 = 600;
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        time_ms += 997 + random % 7;
+        eCO2 += (int32_t)(random >> 8) % 5 - 2;
+        if (eCO2 < CCS811_MIN_eCO2) eCO2 = CCS811_MIN_eCO2;
+        samples[i] = {time_ms, (uint16_t)eCO2, (uint16_t)((eCO2 - CCS811_MIN_eCO2) * 3 / 10)};
+    }
+
+    size_t size = 0;
+    double start = bench_now_s();
+    for (uint32_t pass = 0; pass < PASSES; pass++) {
+        CCS811SampleEncoder encoder(buffer, sizeof(buffer));
+        for (uint32_t i = 0; i < SAMPLES; i++) encoder.append(samples[i]);
+        size = encoder.size();
+        bench_keep(size);
+    }
+    bench_report("encode", (uint64_t)SAMPLES * PASSES, bench_now_s() - start);
+
+    start = bench_now_s();
+    for (uint32_t pass = 0; pass < PASSES; pass++) {
+        CCS811SampleDecoder decoder(buffer, size);
+        ccs811_sample_t sample;
+        uint32_t sum = 0;
+        while (decoder.next(sample)) sum += sample.eCO2;
+        bench_keep(sum);
+    }
+    bench_report("decode", (uint64_t)SAMPLES * PASSES, bench_now_s() - start);
+
+    bench_note("%.2f bytes per sample, %.2fx smaller than 8-byte records", (double)size / SAMPLES,
+               (double)SAMPLES * 8 / size);
+}
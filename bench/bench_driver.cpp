@@ -0,0 +1,41 @@
+#include <MockTwoWireDevice.h>
+#include "CCS811_driver.h"
+#include "bench.h"
+
+/**
+ * Host-side cost of the driver's read paths against a register mock, i.e. the driver's own overhead without bus time.
+ */
+BENCHMARK(driver_reads) {
+    TwoWire bus;
+    MockTwoWireDevice device;
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &device);
+    device.set_register(0x20, CCS811_HARDWARE_ID);
+    const uint8_t frame[] = {0x01, 0x90, 0x00, 0x2A, 0x98, 0x00, 0x51, 0xF4};
+    device.set_register(0x02, frame, sizeof(frame));
+
+    CCS811 sensor;
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);
+
+    const uint32_t iterations = 2000000;
+    ccs811_all_data_t all;
+    double start = bench_now_s();
+    for (uint32_t i = 0; i < iterations; i++) {
+        sensor.read(all);
+        bench_keep(all);
+    }
+    bench_report("read(ccs811_all_data_t&)", iterations, bench_now_s() - start);
+
+    ccs811_air_quality_data_t air;
+    start = bench_now_s();
+    for (uint32_t i = 0; i < iterations; i++) {
+        sensor.read_new(air);
+        bench_keep(air);
+    }
+    bench_report("read_new(ccs811_air_quality_data_t&)", iterations, bench_now_s() - start);
+
+    start = bench_now_s();
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < iterations; i++) sum += sensor.get_eCO2();
+    bench_keep(sum);
+    bench_report("get_eCO2()", iterations, bench_now_s() - start);
+}
@@ -0,0 +1,155 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include "CCS811_driver.h"
+#include "CCS811_simulator.h"
+#include "bench.h"
+
+/**
+ * Recovery cost of the driver's retry policies under scripted bus and sensor faults.
+ *
+ * Each run polls a simulated sensor in CCS811_CONSTANT_POWER_1SEC once per second for two virtual minutes, with one
+ * fault starting 30 s in. The polling loop recovers the way an application would: after a failed read it calls
+ * comms_check(), and if the sensor has fallen back to boot mode it restarts the application and drive mode.
+ *
+ * Reported per scenario and policy:
+ * - lost: samples the sensor produced that never reached the application as a healthy reading
+ * - recovery: time from the end of the fault to the next healthy reading
+ * - bus: modelled bus time at 100 kHz over the whole run; the fault-free scenario gives each policy's floor
+ * - timeouts: bus time lost to stuck-bus timeouts
+ * - waiting: time comms_check() spent between retries
+ */
+
+const uint32_t RUN_MS = 120000;
+const uint32_t FAULT_START_MS = 30000;
+const uint32_t POLL_OFFSET_MS = 10;
+
+typedef struct {
+    const char* name;
+    uint8_t retries;
+    uint16_t delay_ms;
+    bool exponential_backoff;
+    uint8_t short_read_retries;
+} policy_t;
+
+typedef struct {
+    const char* name;
+    uint8_t type;
+    uint32_t duration_ms;
+    uint32_t parameter;
+} scenario_t;
+
+typedef struct {
+    uint32_t lost;
+    uint32_t recovery_ms;
+    uint32_t bus_us;
+    uint64_t timeout_us;
+    uint32_t waiting_ms;
+} outcome_t;
+
+static const policy_t POLICIES[] = {
+    {"no retries", 0, 0, false, 0},
+    {"3 x 10 ms", 3, 10, false, 0},
+    {"10 x 10 ms (default)", 10, 10, false, 0},
+    {"6 x 5 ms backoff", 6, 5, true, 0},
+    {"10 x 10 ms, 2 short-read retries", 10, 10, false, 2},
+};
+
+static const scenario_t SCENARIOS[] = {
+    {"none", CCS811_SIMULATOR_NACKS, 0, 0},
+    {"NACK burst: 30% for 10 s", CCS811_SIMULATOR_NACKS, 10000, 300},
+    {"stuck SDA: 2 s, 25 ms timeouts", CCS811_SIMULATOR_STUCK_BUS, 2000, 25000},
+    {"brown-out mid-burst: 20 ms reboot", CCS811_SIMULATOR_BROWN_OUT, 20, 0},
+    {"heater fault: 5 s", CCS811_SIMULATOR_HEATER_FAULT, 5000, 0},
+};
+
+static void start_measuring(CCS811& sensor) {
+    sensor.start_application_mode();
+    ccs811_measure_config_t config;
+    config.raw = 0;
+    config.drive_mode = CCS811_CONSTANT_POWER_1SEC;
+    sensor.write(config);
+}
+
+static outcome_t run(const scenario_t& scenario, const policy_t& policy) {
+    TwoWire bus;
+    CCS811Simulator simulator;
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &simulator);
+
+    CCS811 sensor;
+    sensor.set_comms_retry_policy(policy.retries, policy.delay_ms, policy.exponential_backoff);
+    sensor.set_short_read_retries(policy.short_read_retries);
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);
+    start_measuring(sensor);
+
+    uint32_t start_ms = millis();
+    uint32_t fault_end_ms = start_ms + FAULT_START_MS + scenario.duration_ms;
+    ccs811_simulator_fault_t fault = {start_ms + FAULT_START_MS, scenario.duration_ms, scenario.type,
+                                      scenario.parameter};
+    simulator.set_fault_script(&fault, 1);
+    simulator.clear_stats();
+    sensor.clear_bus_stats();
+
+    outcome_t outcome = {};
+    uint32_t healthy = 0;
+    bool recovered = scenario.duration_ms == 0;
+    uint32_t next_poll_ms = start_ms + POLL_OFFSET_MS;
+    while ((int32_t)(millis() - (start_ms + RUN_MS)) < 0) {
+        if ((int32_t)(next_poll_ms - millis()) > 0) arduino_host_advance_ms(next_poll_ms - millis());
+        next_poll_ms += CCS811_CONSTANT_POWER_1SEC_SAMPLE_PERIOD_MS;
+
+        ccs811_all_data_t data;
+        CCS811_READ_RESULT result = sensor.read_new(data);
+        if (result == CCS811_READ_ERROR) {
+            sensor.comms_check();
+            continue;
+        }
+        if (result == CCS811_READ_NO_NEW_DATA) {
+            ccs811_status_t status;
+            if (sensor.read(status) and not status.firmware_is_in_application_mode) start_measuring(sensor);
+            continue;
+        }
+        if (data.status.error_has_occurred) {
+            ccs811_error_t error;
+            sensor.read(error);
+            continue;
+        }
+
+        healthy++;
+        if (not recovered and (int32_t)(millis() - fault_end_ms) >= 0) {
+            recovered = true;
+            outcome.recovery_ms = millis() - fault_end_ms;
+        }
+    }
+
+    ccs811_bus_stats_t stats = sensor.get_bus_stats();
+    ccs811_simulator_stats_t simulated = simulator.get_stats();
+    outcome.lost = simulated.samples > healthy ? simulated.samples - healthy : 0;
+    outcome.bus_us = ccs811_bus_time_us(stats, 100000);
+    outcome.timeout_us = simulated.busy_us;
+    outcome.waiting_ms = stats.comms_retry_ms;
+    if (not recovered) outcome.recovery_ms = UINT32_MAX;
+    return outcome;
+}
+
+BENCHMARK(fault_recovery) {
+    const size_t policies = sizeof(POLICIES) / sizeof(POLICIES[0]);
+    const size_t scenarios = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+
+    for (size_t s = 0; s < scenarios; s++) {
+        bench_note("%s", SCENARIOS[s].name);
+        bench_note("  %-34s %6s %12s %12s %12s %10s", "policy", "lost", "recovery ms", "bus us", "timeout us",
+                   "waiting ms");
+        for (size_t p = 0; p < policies; p++) {
+            outcome_t outcome = run(SCENARIOS[s], POLICIES[p]);
+            char recovery[16];
+            if (SCENARIOS[s].duration_ms == 0)
+                snprintf(recovery, sizeof(recovery), "-");
+            else if (outcome.recovery_ms == UINT32_MAX)
+                snprintf(recovery, sizeof(recovery), "never");
+            else
+                snprintf(recovery, sizeof(recovery), "%u", outcome.recovery_ms);
+            bench_note("  %-34s %6u %12s %12u %12llu %10u", POLICIES[p].name, outcome.lost, recovery, outcome.bus_us,
+                       (unsigned long long)outcome.timeout_us, outcome.waiting_ms);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#include <stdlib.h>
+#include "CCS811_filters.h"
+#include "bench.h"
+
+/**
+ * Smoothing one new sample from each of a fleet of sensors: per-sensor state structs updated one at a time, against
+ * the batch forms over a structure of arrays.
+ */
+
+static const size_t SENSORS = 4096;
+static const uint32_t PASSES = 2000;
+
+static uint16_t samples[SENSORS], outputs[SENSORS];
+static ccs811_iir_state_t iir[SENSORS];
+static ccs811_kalman_state_t kalman[SENSORS];
+static int32_t values[SENSORS], estimates[SENSORS];
+static uint32_t variances[SENSORS];
+
+BENCHMARK(batch_filters) {
+    srand(1);
+    for (size_t s = 0; s < SENSORS; s++) {
+        samples[s] = (uint16_t)(400 + rand() % 1000);
+        iir[s] = CCS811_IIR_INITIAL_STATE;
+        kalman[s] = CCS811_KALMAN_INITIAL_STATE;
+        values[s] = estimates[s] = CCS811_FILTER_EMPTY;
+        variances[s] = 0;
+    }
+    const ccs811_kalman_config_t config = {4, 1600};
+
+    double start = bench_now_s();
+    for (uint32_t pass = 0; pass < PASSES; pass++) {
+        for (size_t s = 0; s < SENSORS; s++) outputs[s] = ccs811_iir_update(iir[s], samples[s], 16);
+        bench_keep(outputs[pass % SENSORS]);
+    }
+    bench_report("ccs811_iir_update per sensor", (uint64_t)SENSORS * PASSES, bench_now_s() - start);
+
+    start = bench_now_s();
+    for (uint32_t pass = 0; pass < PASSES; pass++) {
+        ccs811_iir_update_batch(values, samples, outputs, SENSORS, 16);
+        bench_keep(outputs[pass % SENSORS]);
+    }
+    bench_report("ccs811_iir_update_batch", (uint64_t)SENSORS * PASSES, bench_now_s() - start);
+
+    start = bench_now_s();
+    for (uint32_t pass = 0; pass < PASSES; pass++) {
+        for (size_t s = 0; s < SENSORS; s++) outputs[s] = ccs811_kalman_update(kalman[s], config, samples[s]);
+        bench_keep(outputs[pass % SENSORS]);
+    }
+    bench_report("ccs811_kalman_update per sensor", (uint64_t)SENSORS * PASSES, bench_now_s() - start);
+
+    start = bench_now_s();
+    for (uint32_t pass = 0; pass < PASSES; pass++) {
+        ccs811_kalman_update_batch(estimates, variances, samples, outputs, SENSORS, config);
+        bench_keep(outputs[pass % SENSORS]);
+    }
+    bench_report("ccs811_kalman_update_batch", (uint64_t)SENSORS * PASSES, bench_now_s() - start);
+}
@@ -0,0 +1,51 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "bench.h"
+
+static bench_case_t* first_bench = nullptr;
+static bench_case_t* last_bench = nullptr;
+
+void bench_register(bench_case_t* bench) {
+    if (last_bench)
+        last_bench->next = bench;
+    else
+        first_bench = bench;
+    last_bench = bench;
+}
+
+/**
+ * Wall-clock time for measuring benchmark loops; the driver itself runs on the virtual Arduino clock.
+ */
+double bench_now_s() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void bench_report(const char* label, uint64_t operations, double seconds) {
+    double ns = operations ? seconds * 1e9 / operations : 0;
+    double rate = seconds > 0 ? operations / seconds / 1e6 : 0;
+    printf("  %-40s %12llu ops %10.2f ns/op %10.2f Mops/s\n", label, (unsigned long long)operations, ns, rate);
+}
+
+void bench_note(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    printf("  ");
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
+/**
+ * Run every registered benchmark, or only those whose name contains the first argument.
+ */
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    for (bench_case_t* bench = first_bench; bench; bench = bench->next) {
+        if (filter and not strstr(bench->name, filter)) continue;
+        printf("%s\n", bench->name);
+        bench->function();
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <stdlib.h>
+#include "CCS811_processing.h"
+#include "bench.h"
+
+/**
+ * Batch processing of recorded samples:
+ * - decoding ALG_RESULT_DATA frames, the vector path (SSE2 or NEON) against decoding each frame in a scalar loop
+ * - converting raw readings to resistance, reciprocal lookup table against a divide per sample
+ */
+
+static const size_t FRAMES = 1 << 16;
+static const uint32_t PASSES = 200;
+
+static uint8_t frames[FRAMES * CCS811_FRAME_SIZE];
+static uint16_t eCO2[FRAMES], eTVOC[FRAMES], adc[FRAMES];
+static uint8_t status[FRAMES], error[FRAMES], current[FRAMES];
+
+static void decode_frames_scalar(const uint8_t* data, size_t count, const ccs811_frame_columns_t& columns) {
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* frame = data + i * CCS811_FRAME_SIZE;
+        columns.eCO2[i] = (uint16_t)(frame[0] << 8 | frame[1]);
+        columns.eTVOC[i] = (uint16_t)(frame[2] << 8 | frame[3]);
+        columns.status[i] = frame[4];
+        columns.error[i] = frame[5];
+        columns.current_uA[i] = frame[6] >> 2;
+        columns.adc_reading[i] = (uint16_t)((frame[6] & 0x03) << 8 | frame[7]);
+    }
+}
+
+BENCHMARK(batch_decode) {
+    srand(1);
+    for (size_t i = 0; i < sizeof(frames); i++) frames[i] = (uint8_t)rand();
+    ccs811_frame_columns_t all = {eCO2, eTVOC, status, error, current, adc};
+    ccs811_frame_columns_t air_quality = {eCO2, eTVOC, nullptr, nullptr, nullptr, nullptr};
+
+    double start = bench_now_s();
+    for (uint32_t pass = 0; pass < PASSES; pass++) {
+        decode_frames_scalar(frames, FRAMES, all);
+        bench_keep(eCO2[pass]);
+    }
+    bench_report("frame at a time, all columns", (uint64_t)FRAMES * PASSES, bench_now_s() - start);
+
+    start = bench_now_s();
+    for (uint32_t pass = 0; pass < PASSES; pass++) {
+        ccs811_decode_frames(frames, FRAMES, all);
+        bench_keep(eCO2[pass]);
+    }
+    bench_report("ccs811_decode_frames, all columns", (uint64_t)FRAMES * PASSES, bench_now_s() - start);
+
+    start = bench_now_s();
+    for (uint32_t pass = 0; pass < PASSES; pass++) {
+        ccs811_decode_frames(frames, FRAMES, air_quality);
+        bench_keep(eCO2[pass]);
+    }
+    bench_report("ccs811_decode_frames, eCO2 and eTVOC", (uint64_t)FRAMES * PASSES, bench_now_s() - start);
+}
+
+static ccs811_raw_data_t raw[FRAMES];
+static float resistances[FRAMES];
+
+static void resistances_divide(const ccs811_raw_data_t* data, float* output, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        output[i] = data[i].current_uA ? data[i].adc_reading * (CCS811_ADC_REFERENCE_VOLTAGE / CCS811_ADC_FULL_SCALE) /
+                                             (data[i].current_uA * 1e-6f)
+                                       : 0;
+    }
+}
+
+BENCHMARK(batch_resistance) {
+    srand(1);
+    for (size_t i = 0; i < FRAMES; i++) {
+        raw[i].raw[0] = (uint8_t)rand();
+        raw[i].raw[1] = (uint8_t)rand();
+    }
+
+    double start = bench_now_s();
+    for (uint32_t pass = 0; pass < PASSES; pass++) {
+        resistances_divide(raw, resistances, FRAMES);
+        bench_keep(resistances[pass]);
+    }
+    bench_report("divide per sample", (uint64_t)FRAMES * PASSES, bench_now_s() - start);
+
+    start = bench_now_s();
+    for (uint32_t pass = 0; pass < PASSES; pass++) {
+        ccs811_resistances(raw, resistances, FRAMES);
+        bench_keep(resistances[pass]);
+    }
+    bench_report("ccs811_resistances", (uint64_t)FRAMES * PASSES, bench_now_s() - start);
+}
@@ -0,0 +1,49 @@
+#include <Arduino.h>
+#include "CCS811_driver.h"
+#include "CCS811_simulator.h"
+#include "bench.h"
+
+const uint16_t FLEET_SIZE = 1000;
+
+/**
+ * A fleet of simulated sensors, one bus each, all polled once per sample period on the virtual clock.
+ */
+BENCHMARK(simulator_fleet) {
+    static TwoWire buses[FLEET_SIZE];
+    static CCS811Simulator* simulators[FLEET_SIZE];
+    static CCS811 sensors[FLEET_SIZE];
+
+    for (uint16_t i = 0; i < FLEET_SIZE; i++) {
+        ccs811_simulator_config_t config = CCS811_DEFAULT_SIMULATOR_CONFIG;
+        config.seed = i + 1;
+        simulators[i] = new CCS811Simulator(config);
+        simulators[i]->power_on(true);
+        buses[i].attach(CCS811_DEFAULT_I2C_ADDRESS, simulators[i]);
+        sensors[i].begin(CCS811_DEFAULT_I2C_ADDRESS, buses[i]);
+
+        ccs811_measure_config_t measure;
+        measure.raw = 0;
+        measure.drive_mode = CCS811_CONSTANT_POWER_1SEC;
+        sensors[i].write(measure);
+    }
+
+    const uint32_t seconds = 600;
+    uint64_t samples = 0;
+    double start = bench_now_s();
+    for (uint32_t second = 0; second < seconds; second++) {
+        arduino_host_advance_ms(1000);
+        for (uint16_t i = 0; i < FLEET_SIZE; i++) {
+            ccs811_air_quality_data_t data;
+            samples += sensors[i].read_new(data) == CCS811_READ_NEW_DATA;
+        }
+    }
+    double elapsed = bench_now_s() - start;
+
+    bench_report("read_new() per simulated sensor", (uint64_t)seconds * FLEET_SIZE, elapsed);
+    bench_note("%llu samples from %u sensors over %u virtual seconds in %.3f s", (unsigned long long)samples,
+               FLEET_SIZE, seconds, elapsed);
+    for (uint16_t i = 0; i < FLEET_SIZE; i++) {
+        buses[i].detach(CCS811_DEFAULT_I2C_ADDRESS);
+        delete simulators[i];
+    }
+}
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <thread>
+#include "CCS811_statistics.h"
+#include "bench.h"
+
+/**
+ * Hourly eCO2 aggregates over a month of 1 s samples (8 MB of blocks), on one thread and split into block-aligned
+ * slices over several threads whose bucket arrays are merged afterwards.
+ */
+
+static const size_t BLOCKS = 1 << 14;
+static const size_t HOURS = 31 * 24;
+static uint8_t segment[BLOCKS * CCS811_BLOCK_SIZE];
+
+static uint32_t aggregate_parallel(const ccs811_aggregate_query_t& query, CCS811Aggregate* result, unsigned threads) {
+    static CCS811Aggregate partial[8][HOURS];
+    uint32_t counts[8] = {};
+    std::thread workers[8];
+    size_t blocks_per_thread = (BLOCKS + threads - 1) / threads;
+
+    for (unsigned t = 0; t < threads; t++) {
+        workers[t] = std::thread([&, t]() {
+            size_t first = t * blocks_per_thread;
+            size_t count = first + blocks_per_thread < BLOCKS ? blocks_per_thread : BLOCKS - first;
+            for (size_t h = 0; h < HOURS; h++) partial[t][h].reset();
+            CCS811SegmentReader reader(segment + first * CCS811_BLOCK_SIZE, count * CCS811_BLOCK_SIZE);
+            counts[t] = ccs811_aggregate_segment(reader, query, partial[t], HOURS);
+        });
+    }
+
+    uint32_t aggregated = 0;
+    for (size_t h = 0; h < HOURS; h++) result[h].reset();
+    for (unsigned t = 0; t < threads; t++) {
+        workers[t].join();
+        for (size_t h = 0; h < HOURS; h++) result[h].merge(partial[t][h]);
+        aggregated += counts[t];
+    }
+    return aggregated;
+}
+
+BENCHMARK(segment_aggregation) {
+    uint32_t time_ms = 0;
+    uint32_t samples = 0;
+    for (size_t b = 0; b < BLOCKS; b++) {
+        CCS811BlockWriter writer(segment + b * CCS811_BLOCK_SIZE);
+        while (writer.append({time_ms, (uint16_t)(400 + samples * 7 % 1000), 0})) {
+            time_ms += 1000;
+            samples++;
+        }
+        writer.finish();
+    }
+
+    static CCS811Aggregate hourly[HOURS];
+    ccs811_aggregate_query_t query = {0, 3600000, CCS811_FIELD_eCO2, 1000, 1500};
+    const uint32_t passes = 5;
+
+    for (unsigned threads = 1; threads <= 8; threads *= 2) {
+        uint32_t aggregated = 0;
+        double start = bench_now_s();
+        for (uint32_t pass = 0; pass < passes; pass++) aggregated = aggregate_parallel(query, hourly, threads);
+        double seconds = bench_now_s() - start;
+
+        char label[48];
+        snprintf(label, sizeof(label), "hourly aggregate, %u thread%s", threads, threads > 1 ? "s" : "");
+        bench_report(label, (uint64_t)aggregated * passes, seconds);
+    }
+    bench_note("%u samples in %u blocks", samples, (unsigned)BLOCKS);
+}
+
+/**
+ * Rolling window updates, against rescanning the window for every value.
+ */
+BENCHMARK(rolling_window) {
+    const uint32_t values = 10000000;
+    static uint16_t series[1 << 16];
+    uint32_t random = 1;
+    for (size_t i = 0; i < sizeof(series) / sizeof(series[0]); i++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        series[i] = random % 8192;
+    }
+
+    CCS811RollingWindow<240> window;
+    double start = bench_now_s();
+    for (uint32_t i = 0; i < values; i++) {
+        window.add(series[i & 0xFFFF]);
+        bench_keep(window.get_max());
+    }
+    bench_report("CCS811RollingWindow<240>::add", values, bench_now_s() - start);
+
+    const uint32_t rescans = 200000;
+    start = bench_now_s();
+    for (uint32_t i = 240; i < rescans; i++) {
+        uint16_t high = 0;
+        for (uint32_t j = i - 240; j < i; j++) high = series[j & 0xFFFF] > high ? series[j & 0xFFFF] : high;
+        bench_keep(high);
+    }
+    bench_report("rescan of 240 values", rescans - 240, bench_now_s() - start);
+}
@@ -0,0 +1,50 @@
+#include "CCS811_storage.h"
+#include "bench.h"
+
+/**
+ * Segment scans over 8 MB of stored 1 s samples, about a month of one sensor:
+ * - CRC-32 throughput
+ * - a one-day range query, checking headers before checksums, against validating every block and then filtering
+ */
+
+static const size_t BLOCKS = 1 << 14;
+static uint8_t segment[BLOCKS * CCS811_BLOCK_SIZE];
+
+BENCHMARK(segment_range_query) {
+    uint32_t time_ms = 0;
+    for (size_t b = 0; b < BLOCKS; b++) {
+        CCS811BlockWriter writer(segment + b * CCS811_BLOCK_SIZE);
+        while (writer.append({time_ms, (uint16_t)(400 + time_ms / 1000 % 600), 0})) time_ms += 1000;
+        writer.finish();
+    }
+
+    double start = bench_now_s();
+    uint32_t crc = ccs811_crc32(segment, sizeof(segment));
+    bench_keep(crc);
+    double seconds = bench_now_s() - start;
+    bench_report("crc32 per block", BLOCKS, seconds);
+    bench_note("crc32: %.0f MB/s", sizeof(segment) / seconds / 1e6);
+
+    const uint32_t query_start_ms = time_ms / 2;
+    const uint32_t query_end_ms = query_start_ms + 86400000;
+    const uint32_t passes = 20;
+
+    uint32_t found = 0;
+    start = bench_now_s();
+    for (uint32_t pass = 0; pass < passes; pass++) {
+        CCS811SegmentReader reader(segment, sizeof(segment));
+        ccs811_block_header_t header;
+        while (reader.next_block(header)) found += ccs811_block_overlaps(header, query_start_ms, query_end_ms);
+    }
+    bench_report("validate every block, then filter", (uint64_t)BLOCKS * passes, bench_now_s() - start);
+
+    uint32_t found_by_header = 0;
+    start = bench_now_s();
+    for (uint32_t pass = 0; pass < passes; pass++) {
+        CCS811SegmentReader reader(segment, sizeof(segment));
+        ccs811_block_header_t header;
+        while (reader.next_block(header, query_start_ms, query_end_ms)) found_by_header++;
+    }
+    bench_report("next_block(range)", (uint64_t)BLOCKS * passes, bench_now_s() - start);
+    bench_note("%u blocks matched per query (%u by header)", found / passes, found_by_header / passes);
+}
@@ -0,0 +1,86 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include "CCS811_driver.h"
+#include "CCS811_simulator.h"
+#include "CCS811_trace.h"
+#include "bench.h"
+
+/**
+ * Acquisition throughput on a replayed bus trace, i.e. the driver and host stack without a sensor or bus time.
+ *
+ * By default the trace is an hour of once-a-second read_new() polling recorded from the simulator. Set CCS811_TRACE to
+ * a trace file captured on a node running the same loop (one read_new(ccs811_all_data_t&) per poll) to replay
+ * real-world data instead; transactions that do not fit that loop are reported as mismatches.
+ */
+
+static const size_t TRACE_CAPACITY = 1 << 20;
+static const uint32_t RECORDED_POLLS = 3600;
+
+static uint8_t trace[TRACE_CAPACITY];
+
+static size_t record_trace() {
+    TwoWire bus;
+    ccs811_simulator_config_t config = CCS811_DEFAULT_SIMULATOR_CONFIG;
+    config.walk_step = 25;
+    CCS811Simulator simulator(config);
+    simulator.power_on(true);
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &simulator);
+
+    CCS811 sensor;
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);
+    ccs811_measure_config_t measure;
+    measure.raw = 0;
+    measure.drive_mode = CCS811_CONSTANT_POWER_1SEC;
+    sensor.write(measure);
+
+    CCS811TraceRecorder recorder(TRACE_CAPACITY);
+    recorder.start(sensor);
+    for (uint32_t poll = 0; poll < RECORDED_POLLS; poll++) {
+        arduino_host_advance_ms(CCS811_CONSTANT_POWER_1SEC_SAMPLE_PERIOD_MS);
+        ccs811_all_data_t data;
+        sensor.read_new(data);
+    }
+    recorder.stop(sensor);
+    memcpy(trace, recorder.get_trace(), recorder.get_size());
+    return recorder.get_size();
+}
+
+BENCHMARK(trace_replay) {
+    size_t size = 0;
+    const char* path = getenv("CCS811_TRACE");
+    if (path) {
+        if (not ccs811_trace_load(path, trace, sizeof(trace), size)) {
+            bench_note("cannot load %s", path);
+            return;
+        }
+        bench_note("replaying %s (%u bytes)", path, (unsigned)size);
+    } else {
+        size = record_trace();
+        bench_note("replaying %u simulated polls (%u bytes)", RECORDED_POLLS, (unsigned)size);
+    }
+
+    TwoWire bus;
+    CCS811TraceReplay replay(trace, size);
+    replay.set_loop(true);
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &replay);
+    CCS811 sensor;
+    sensor.set_comms_retry_policy(0, 0);
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);  // Not in the trace; the mismatch is not counted below
+
+    const uint32_t polls = 2000000;
+    uint32_t samples = 0;
+    ccs811_trace_replay_stats_t before = replay.get_stats();
+    double start = bench_now_s();
+    for (uint32_t i = 0; i < polls; i++) {
+        ccs811_all_data_t data;
+        if (sensor.read_new(data) == CCS811_READ_NEW_DATA) samples++;
+        bench_keep(data);
+    }
+    double seconds = bench_now_s() - start;
+    ccs811_trace_replay_stats_t after = replay.get_stats();
+
+    bench_report("replayed poll", polls, seconds);
+    bench_report("replayed transaction", after.transactions - before.transactions, seconds);
+    bench_note("%u new samples, %u trace passes, %u mismatches", samples, after.rewinds - before.rewinds,
+               after.mismatches - before.mismatches);
+}
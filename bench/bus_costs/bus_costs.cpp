@@ -0,0 +1,206 @@
+/**
+ * Bus cost regression suite.
+ * Runs every public CCS811 operation once against a simulated sensor and records its bus transfers, bytes and modelled
+ * bus time at 100 and 400 kHz. The results are compared with a golden baseline file; the run fails if any operation
+ * costs more than its baseline, or has no baseline entry.
+ *
+ * Usage: ccs811_bus_costs <baseline file> [--update]
+ *   --update rewrites the baseline from the current costs, for intentional changes.
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include "CCS811_driver.h"
+#include "CCS811_simulator.h"
+
+typedef void (*operation_fn_t)(CCS811&);
+
+typedef struct {
+    const char* name;
+    operation_fn_t run;
+} operation_t;
+
+typedef struct {
+    uint32_t transfers;
+    uint32_t bytes_written;
+    uint32_t bytes_read;
+    uint32_t time_100khz_us;
+    uint32_t time_400khz_us;
+} cost_t;
+
+static TwoWire* measured_bus = nullptr;  // Bus of the sensor being measured, for operations that take one
+
+template <typename T>
+static void read_register(CCS811& sensor) {
+    T data;
+    sensor.read(data);
+}
+
+template <typename T>
+static void write_register(CCS811& sensor) {
+    T data;
+    memset(&data, 0, sizeof(data));
+    sensor.write(data);
+}
+
+template <typename T>
+static void read_new(CCS811& sensor) {
+    T data;
+    sensor.read_new(data);
+}
+
+static const operation_t OPERATIONS[] = {
+    {"begin", [](CCS811& sensor) { sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, *measured_bus); }},
+    {"comms_check", [](CCS811& sensor) { sensor.comms_check(); }},
+    {"read(status)", read_register<ccs811_status_t>},
+    {"read(measure_config)", read_register<ccs811_measure_config_t>},
+    {"read(co2_thresholds)", read_register<ccs811_co2_thresholds_t>},
+    {"read(eCO2)", read_register<ccs811_eCO2_data_t>},
+    {"read(eTVOC)", read_register<ccs811_eTVOC_data_t>},
+    {"read(raw_data)", read_register<ccs811_raw_data_t>},
+    {"read(air_quality)", read_register<ccs811_air_quality_data_t>},
+    {"read(all_data)", read_register<ccs811_all_data_t>},
+    {"read(baseline)", read_register<ccs811_baseline_t>},
+    {"read(hardware_id)", read_register<ccs811_hardware_id_t>},
+    {"read(hardware_version)", read_register<ccs811_hardware_version_t>},
+    {"read(firmware_boot_version)", read_register<ccs811_firmware_boot_version_t>},
+    {"read(firmware_application_version)", read_register<ccs811_firmware_application_version_t>},
+    {"read(error)", read_register<ccs811_error_t>},
+    {"read_new(air_quality)", read_new<ccs811_air_quality_data_t>},
+    {"read_new(all_data)", read_new<ccs811_all_data_t>},
+    {"write(measure_config)", write_register<ccs811_measure_config_t>},
+    {"write(environmental_data)", write_register<ccs811_environmental_data_t>},
+    {"write(co2_thresholds)", write_register<ccs811_co2_thresholds_t>},
+    {"write(baseline)", write_register<ccs811_baseline_t>},
+    {"write(application_data)", write_register<ccs811_application_data_t>},
+    {"write(application_verify)", write_register<ccs811_application_verify_t>},
+    {"write(application_start)", write_register<ccs811_application_start_t>},
+    {"write_environmental_data", [](CCS811& sensor) { sensor.write_environmental_data(21.5, 45.0); }},
+    {"write_co2_thresholds", [](CCS811& sensor) { sensor.write_co2_thresholds(1500, 2500); }},
+    {"get_eCO2", [](CCS811& sensor) { sensor.get_eCO2(); }},
+    {"get_eTVOC", [](CCS811& sensor) { sensor.get_eTVOC(); }},
+    {"reset", [](CCS811& sensor) { sensor.reset(); }},
+    {"start_application_erase", [](CCS811& sensor) { sensor.start_application_erase(); }},
+    {"start_application_verify", [](CCS811& sensor) { sensor.start_application_verify(); }},
+    {"start_application_mode", [](CCS811& sensor) { sensor.start_application_mode(); }},
+};
+
+static const size_t OPERATION_COUNT = sizeof(OPERATIONS) / sizeof(OPERATIONS[0]);
+static const size_t MAX_NAME_LENGTH = 64;
+
+/**
+ * Measure one operation on a sensor that is measuring and has a sample ready.
+ */
+static cost_t measure(const operation_t& operation) {
+    TwoWire bus;
+    CCS811Simulator simulator;
+    simulator.power_on(true);
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &simulator);
+    measured_bus = &bus;
+
+    CCS811 sensor;
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);
+    ccs811_measure_config_t config;
+    config.raw = 0;
+    config.drive_mode = CCS811_CONSTANT_POWER_1SEC;
+    sensor.write(config);
+    arduino_host_advance_ms(CCS811_CONSTANT_POWER_1SEC_SAMPLE_PERIOD_MS);
+
+    sensor.clear_bus_stats();
+    operation.run(sensor);
+    ccs811_bus_stats_t stats = sensor.get_bus_stats();
+
+    cost_t cost;
+    cost.transfers = stats.transfers;
+    cost.bytes_written = stats.bytes_written;
+    cost.bytes_read = stats.bytes_read;
+    cost.time_100khz_us = ccs811_bus_time_us(stats, 100000);
+    cost.time_400khz_us = ccs811_bus_time_us(stats, 400000);
+    return cost;
+}
+
+/**
+ * Find an operation's entry in the baseline file.
+ * @return True if the operation has a baseline.
+ */
+static bool find_baseline(const char* path, const char* name, cost_t& cost) {
+    FILE* file = fopen(path, "r");
+    if (not file) return false;
+
+    char line[256];
+    char entry[MAX_NAME_LENGTH + 1];
+    bool found = false;
+    while (not found and fgets(line, sizeof(line), file)) {
+        if (line[0] == '#') continue;
+        found = sscanf(line, "%64s %u %u %u %u %u", entry, &cost.transfers, &cost.bytes_written, &cost.bytes_read,
+                       &cost.time_100khz_us, &cost.time_400khz_us) == 6 and
+                strcmp(entry, name) == 0;
+    }
+    fclose(file);
+    return found;
+}
+
+static bool more_expensive(const cost_t& cost, const cost_t& baseline) {
+    return cost.transfers > baseline.transfers or cost.bytes_written > baseline.bytes_written or
+           cost.bytes_read > baseline.bytes_read or cost.time_100khz_us > baseline.time_100khz_us or
+           cost.time_400khz_us > baseline.time_400khz_us;
+}
+
+static bool cheaper(const cost_t& cost, const cost_t& baseline) {
+    return not more_expensive(cost, baseline) and memcmp(&cost, &baseline, sizeof(cost)) != 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <baseline file> [--update]\n", argv[0]);
+        return 2;
+    }
+    const char* path = argv[1];
+    bool update = argc > 2 and strcmp(argv[2], "--update") == 0;
+
+    cost_t costs[OPERATION_COUNT];
+    for (size_t i = 0; i < OPERATION_COUNT; i++) costs[i] = measure(OPERATIONS[i]);
+
+    if (update) {
+        FILE* file = fopen(path, "w");
+        if (not file) {
+            fprintf(stderr, "cannot write %s\n", path);
+            return 2;
+        }
+        fprintf(file, "# Bus cost per CCS811 operation. Regenerate with: ccs811_bus_costs <this file> --update\n");
+        fprintf(file, "# operation transfers bytes_written bytes_read bus_us_100khz bus_us_400khz\n");
+        for (size_t i = 0; i < OPERATION_COUNT; i++) {
+            fprintf(file, "%s %u %u %u %u %u\n", OPERATIONS[i].name, costs[i].transfers, costs[i].bytes_written,
+                    costs[i].bytes_read, costs[i].time_100khz_us, costs[i].time_400khz_us);
+        }
+        fclose(file);
+        printf("wrote %u operations to %s\n", (unsigned)OPERATION_COUNT, path);
+        return 0;
+    }
+
+    int failures = 0;
+    printf("%-36s %9s %7s %6s %9s %9s\n", "operation", "transfers", "written", "read", "us@100k", "us@400k");
+    for (size_t i = 0; i < OPERATION_COUNT; i++) {
+        const cost_t& cost = costs[i];
+        printf("%-36s %9u %7u %6u %9u %9u", OPERATIONS[i].name, cost.transfers, cost.bytes_written, cost.bytes_read,
+               cost.time_100khz_us, cost.time_400khz_us);
+
+        cost_t baseline;
+        if (not find_baseline(path, OPERATIONS[i].name, baseline)) {
+            printf("  NO BASELINE\n");
+            failures++;
+        } else if (more_expensive(cost, baseline)) {
+            printf("  REGRESSION (baseline %u transfers, %u+%u bytes)\n", baseline.transfers, baseline.bytes_written,
+                   baseline.bytes_read);
+            failures++;
+        } else if (cheaper(cost, baseline)) {
+            printf("  improved; update the baseline\n");
+        } else {
+            printf("\n");
+        }
+    }
+
+    printf("%u operations, %d over baseline\n", (unsigned)OPERATION_COUNT, failures);
+    return failures ? 1 : 0;
+}
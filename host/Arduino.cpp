@@ -0,0 +1,35 @@
+#include "Arduino.h"
+
+static uint64_t virtual_time_us = 0;
+
+unsigned long millis() { return (unsigned long)(uint32_t)(virtual_time_us / 1000); }
+
+unsigned long micros() { return (unsigned long)(uint32_t)virtual_time_us; }
+
+void delay(unsigned long ms) { virtual_time_us += (uint64_t)ms * 1000; }
+
+void delayMicroseconds(unsigned int us) { virtual_time_us += us; }
+
+/**
+ * Get the virtual clock without the 32-bit wrap of micros().
+ * @return Time in microseconds.
+ */
+uint64_t arduino_host_time_us() { return virtual_time_us; }
+
+/**
+ * Set the virtual clock.
+ * @param time_us: New time in microseconds.
+ */
+void arduino_host_set_us(uint64_t time_us) { virtual_time_us = time_us; }
+
+/**
+ * Move the virtual clock forward.
+ * @param ms: Milliseconds to advance.
+ */
+void arduino_host_advance_ms(uint32_t ms) { virtual_time_us += (uint64_t)ms * 1000; }
+
+/**
+ * Move the virtual clock forward.
+ * @param us: Microseconds to advance.
+ */
+void arduino_host_advance_us(uint32_t us) { virtual_time_us += us; }
@@ -0,0 +1,31 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+/**
+ * Host stand-in for the parts of the Arduino core the library uses.
+ * Time is virtual: millis() only moves when delay() or arduino_host_advance_ms() is called, so tests and benchmarks run
+ * independently of the wall clock.
+ */
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "avr/pgmspace.h"
+
+#define F(string) (string)
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+///////////////////////////////////////////////////////////////////////////////
+// HOST ONLY
+
+uint64_t arduino_host_time_us();
+void arduino_host_set_us(uint64_t time_us);
+void arduino_host_advance_ms(uint32_t ms);
+void arduino_host_advance_us(uint32_t us);
+
+#endif
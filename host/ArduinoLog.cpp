@@ -0,0 +1,3 @@
+#include "ArduinoLog.h"
+
+Logging Log;
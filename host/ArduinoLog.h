@@ -0,0 +1,19 @@
+#ifndef ARDUINO_LOG_H
+#define ARDUINO_LOG_H
+
+/**
+ * Host stand-in for ArduinoLog. Messages are discarded; the calls only have to compile and cost nothing.
+ */
+class Logging {
+   public:
+    void fatal(const char*, ...) {}
+    void error(const char*, ...) {}
+    void warning(const char*, ...) {}
+    void notice(const char*, ...) {}
+    void trace(const char*, ...) {}
+    void verbose(const char*, ...) {}
+};
+
+extern Logging Log;
+
+#endif
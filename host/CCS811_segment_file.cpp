@@ -0,0 +1,81 @@
+#include "CCS811_segment_file.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CCS811SegmentFile::CCS811SegmentFile() {}
+
+CCS811SegmentFile::~CCS811SegmentFile() { close(); }
+
+/**
+ * Open and map a segment file. Any file opened before is closed first.
+ * @param path: Segment file to read.
+ * @return False if the file cannot be opened or mapped. An empty file opens with nothing mapped.
+ */
+bool CCS811SegmentFile::open(const char* path) {
+    close();
+    _descriptor = ::open(path, O_RDONLY);
+    if (_descriptor < 0) return false;
+    if (map()) return true;
+    close();
+    return false;
+}
+
+void CCS811SegmentFile::close() {
+    unmap();
+    if (_descriptor >= 0) ::close(_descriptor);
+    _descriptor = -1;
+}
+
+/**
+ * Map the blocks appended to the file since it was opened or last refreshed.
+ * The new mapping is made before the old one is released, so the reader stays valid if remapping fails.
+ * @param reader: Reader over this file's mapping; it is moved to the new mapping and keeps its position.
+ * @return True if the file grew and the reader can see more of it.
+ */
+bool CCS811SegmentFile::refresh(CCS811SegmentReader& reader) {
+    struct stat status;
+    if (_descriptor < 0 or fstat(_descriptor, &status) != 0 or (size_t)status.st_size <= _size) return false;
+
+    const uint8_t* old_data = _data;
+    size_t old_size = _size;
+    if (not map()) {
+        _data = old_data;
+        _size = old_size;
+        return false;
+    }
+    if (old_data) munmap(const_cast<uint8_t*>(old_data), old_size);
+    _remaps++;
+    reader.extend(_data, _size);
+    return true;
+}
+
+/**
+ * Map the whole file and advise the kernel that it will be read once, front to back.
+ * @return False if the file cannot be mapped.
+ */
+bool CCS811SegmentFile::map() {
+    struct stat status;
+    if (fstat(_descriptor, &status) != 0) return false;
+    if (status.st_size == 0) {
+        _data = nullptr;
+        _size = 0;
+        return true;
+    }
+
+    void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_SHARED, _descriptor, 0);
+    if (data == MAP_FAILED) return false;
+    // Hints only: read ahead aggressively and drop pages behind the scan
+    madvise(data, (size_t)status.st_size, MADV_SEQUENTIAL);
+    madvise(data, (size_t)status.st_size, MADV_WILLNEED);
+    _data = static_cast<const uint8_t*>(data);
+    _size = (size_t)status.st_size;
+    return true;
+}
+
+void CCS811SegmentFile::unmap() {
+    if (_data) munmap(const_cast<uint8_t*>(_data), _size);
+    _data = nullptr;
+    _size = 0;
+}
@@ -0,0 +1,45 @@
+#ifndef CCS811_SEGMENT_FILE_H
+#define CCS811_SEGMENT_FILE_H
+
+/**
+ * Memory-mapped segment files for readers on a POSIX host, e.g. analytics jobs on a gateway that collects the blocks
+ * written by its nodes. The library itself only sees the mapping through CCS811SegmentReader, so it builds unchanged
+ * for targets without mmap().
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "CCS811_storage.h"
+
+/**
+ * Read-only mapping of a segment file, advised for a sequential scan.
+ * A writer may keep appending to the file; refresh() maps the blocks appended since and hands the new mapping to a
+ * reader. A remap can move the mapping, so each reader thread opens its own CCS811SegmentFile.
+ */
+class CCS811SegmentFile {
+   public:
+    CCS811SegmentFile();
+    ~CCS811SegmentFile();
+
+    bool open(const char* path);
+    void close();
+    bool refresh(CCS811SegmentReader& reader);
+
+    const uint8_t* get_data() { return _data; }
+    size_t get_size() { return _size; }
+    uint32_t get_remaps() { return _remaps; }
+
+   private:
+    int _descriptor = -1;
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+    uint32_t _remaps = 0;
+
+    bool map();
+    void unmap();
+
+    CCS811SegmentFile(const CCS811SegmentFile&);
+    CCS811SegmentFile& operator=(const CCS811SegmentFile&);
+};
+
+#endif
@@ -0,0 +1,472 @@
+#include "CCS811_simulator.h"
+#include <Arduino.h>
+#include <string.h>
+
+static const uint16_t MINIMUM_ECO2 = 400;
+static const uint16_t MAXIMUM_ECO2 = 8192;
+static const uint16_t MAXIMUM_ETVOC = 1187;
+static const uint8_t SENSOR_CURRENT_UA = 20;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Create a simulated sensor, powered on in boot mode with valid application firmware like a factory part.
+ * @param config: Initial readings, timing and fault injection settings.
+ */
+CCS811Simulator::CCS811Simulator(const ccs811_simulator_config_t& config)
+    : _config(config), _random(config.seed ? config.seed : 1), _application_valid(true) {
+    _application_data_bytes = 0;
+    _eCO2 = config.eCO2 < MINIMUM_ECO2 ? MINIMUM_ECO2 : config.eCO2;
+    _eTVOC = config.eTVOC;
+    _raw = 0;
+    power_on();
+}
+
+/**
+ * Power cycle the sensor. Registers return to their reset values; the firmware image in flash is kept.
+ * @param application_mode: True to skip the APP_START a host would normally send after power on.
+ */
+void CCS811Simulator::power_on(bool application_mode) {
+    _application_mode = false;
+    _application_verified = false;
+    _erase_completed = false;
+    _erase_done_us = 0;
+    _verify_done_us = 0;
+
+    _selected = STATUS;
+    _measure_config.raw = 0;
+    _error.raw = 0;
+    _data_ready = false;
+    _measure_start_us = arduino_host_time_us();
+    _sample_index = 0;
+
+    const uint8_t baseline[] = {0x84, 0x7B};
+    const uint8_t environment[] = {0x64, 0x00, 0x64, 0x00};  // 50 %RH, 25 degC
+    const uint8_t thresholds[] = {0x05, 0xDC, 0x09, 0xC4};   // 1500 and 2500 ppm
+    memcpy(_baseline, baseline, sizeof(_baseline));
+    memcpy(_environment, environment, sizeof(_environment));
+    memcpy(_thresholds, thresholds, sizeof(_thresholds));
+
+    if (application_mode and _application_valid) _application_mode = true;
+}
+
+/**
+ * Script faults to inject at set times. Each brown-out fires once; the others apply while active.
+ * @param faults: Fault entries, owned by the caller and kept alive while the script is set. nullptr clears the script.
+ * @param count: Number of entries, at most CCS811_SIMULATOR_MAX_FAULTS.
+ */
+void CCS811Simulator::set_fault_script(const ccs811_simulator_fault_t* faults, uint8_t count) {
+    _faults = faults;
+    _fault_count = faults ? (count < CCS811_SIMULATOR_MAX_FAULTS ? count : CCS811_SIMULATOR_MAX_FAULTS) : 0;
+    _faults_triggered = 0;
+    _brown_out_pending = false;
+    _heater_fault = false;
+}
+
+/**
+ * Set the readings reported from the next sample on.
+ * @param eCO2: Equivalent CO2 in ppm.
+ * @param eTVOC: Equivalent TVOC in ppb.
+ */
+void CCS811Simulator::set_air_quality(uint16_t eCO2, uint16_t eTVOC) {
+    update();
+    _config.eCO2 = eCO2;
+    _config.eTVOC = eTVOC;
+    _eCO2 = eCO2;
+    _eTVOC = eTVOC;
+}
+
+/**
+ * Check the nINT pin.
+ * @return True if the data ready interrupt is enabled and a sample is waiting.
+ */
+bool CCS811Simulator::is_interrupt_asserted() {
+    update();
+    return _measure_config.interrupt_on_data_ready_enabled and _data_ready;
+}
+
+/**
+ * Get the STATUS register as the host would read it now.
+ */
+uint8_t CCS811Simulator::get_status() {
+    update();
+    ccs811_status_t status;
+    status.raw = 0;
+    status.error_has_occurred = _error.raw != 0;
+    status.data_ready = _data_ready;
+    status.application_firmware_loaded = _application_valid;
+    status.application_firmware_verified = not _application_mode and _application_verified;
+    status.application_firmware_erase_completed = not _application_mode and _erase_completed;
+    status.firmware_is_in_application_mode = _application_mode;
+    return status.raw;
+}
+
+/**
+ * Get the virtual time the next sample becomes ready.
+ * @return Time in microseconds, or 0 if the sensor is not measuring.
+ */
+uint64_t CCS811Simulator::get_next_sample_us() {
+    update();
+    uint64_t period = sample_period_us();
+    if (not _application_mode or period == 0) return 0;
+    return _measure_start_us + (_sample_index + 1) * period;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint8_t CCS811Simulator::on_write(const uint8_t* data, size_t length) {
+    uint8_t result = check_transaction();
+    if (result != TWO_WIRE_OK) return result;
+    if (_brown_out_pending and length > 1) {  // Register selects pass; the data transfer is cut
+        brown_out();
+        return TWO_WIRE_DATA_NACK;
+    }
+    update();
+    if (length == 0) return TWO_WIRE_OK;
+
+    _selected = data[0];
+    write_register(data[0], data + 1, length - 1);
+    return TWO_WIRE_OK;
+}
+
+uint8_t CCS811Simulator::on_read(uint8_t* data, uint8_t length) {
+    if (check_transaction() != TWO_WIRE_OK) return 0;
+    update();
+    uint8_t supplied = read_register(data, length);
+    if (_brown_out_pending) {
+        brown_out();
+        supplied = length / 2;  // Power lost part way through the burst
+    }
+    return supplied;
+}
+
+/**
+ * Account for a transaction and decide whether it is acknowledged.
+ * @return TWO_WIRE_OK, or the error the bus master sees.
+ */
+uint8_t CCS811Simulator::check_transaction() {
+    _stats.transactions++;
+    uint64_t now_us = arduino_host_time_us();
+    uint16_t nack_per_mille = _config.nack_per_mille;
+    uint32_t stuck_timeout_us = 0;
+    if (_fault_count) apply_faults(now_us, nack_per_mille, stuck_timeout_us);
+
+    if (stuck_timeout_us) {
+        arduino_host_advance_us(stuck_timeout_us);
+        _stats.busy_us += stuck_timeout_us;
+        _stats.nacks++;
+        return TWO_WIRE_OTHER_ERROR;
+    }
+    if (_config.latency_us) {
+        arduino_host_advance_us(_config.latency_us);
+        _stats.busy_us += _config.latency_us;
+    }
+    if (now_us < _offline_until_us) {
+        _stats.nacks++;
+        return TWO_WIRE_ADDRESS_NACK;
+    }
+    if (nack_per_mille and next_random() % 1000 < nack_per_mille) {
+        _stats.nacks++;
+        return TWO_WIRE_DATA_NACK;
+    }
+    return TWO_WIRE_OK;
+}
+
+/**
+ * Evaluate the fault script at the current time.
+ * @param now_us: Current virtual time.
+ * @param nack_per_mille: Raised to the highest NACK rate of the active NACK faults.
+ * @param stuck_timeout_us: Set to the timeout of an active stuck bus fault.
+ */
+void CCS811Simulator::apply_faults(uint64_t now_us, uint16_t& nack_per_mille, uint32_t& stuck_timeout_us) {
+    _heater_fault = false;
+    for (uint8_t i = 0; i < _fault_count; i++) {
+        const ccs811_simulator_fault_t& fault = _faults[i];
+        uint64_t start_us = (uint64_t)fault.start_ms * 1000;
+        uint64_t end_us = start_us + (uint64_t)fault.duration_ms * 1000;
+        if (now_us < start_us) continue;
+
+        bool active = now_us < end_us;
+        switch (fault.type) {
+            case CCS811_SIMULATOR_NACKS:
+                if (active and fault.parameter > nack_per_mille) nack_per_mille = fault.parameter;
+                break;
+            case CCS811_SIMULATOR_STUCK_BUS:
+                if (active) stuck_timeout_us = fault.parameter ? fault.parameter : 1;
+                break;
+            case CCS811_SIMULATOR_BROWN_OUT:
+                if (not(_faults_triggered & (1UL << i))) {
+                    _faults_triggered |= 1UL << i;
+                    _brown_out_pending = true;
+                    _brown_out_offline_us = (uint64_t)fault.duration_ms * 1000;
+                }
+                break;
+            case CCS811_SIMULATOR_HEATER_FAULT:
+                if (active) _heater_fault = true;
+                break;
+        }
+    }
+    if (_heater_fault) _error.heater_current_not_in_range = true;
+}
+
+/**
+ * Lose power in the middle of the current transaction: the sensor resets and stays off the bus while it reboots.
+ */
+void CCS811Simulator::brown_out() {
+    _brown_out_pending = false;
+    _stats.brown_outs++;
+    power_on();
+    _offline_until_us = arduino_host_time_us() + _brown_out_offline_us;
+}
+
+/**
+ * Apply a write to a register, or run the command it starts.
+ * @param reg: Register address.
+ * @param payload: Bytes following the address.
+ * @param length: Number of payload bytes; 0 for an address-only write.
+ */
+void CCS811Simulator::write_register(uint8_t reg, const uint8_t* payload, size_t length) {
+    uint64_t now_us = arduino_host_time_us();
+
+    if (reg == SW_RESET) {
+        if (length == sizeof(CCS811_RESET_SEQUENCE) and memcmp(payload, CCS811_RESET_SEQUENCE, length) == 0) {
+            power_on();
+        } else if (length) {
+            _error.write_register_invalid = true;
+        }
+        return;
+    }
+
+    if (not _application_mode) {
+        switch (reg) {
+            case APP_ERASE:
+                if (length == sizeof(CCS811_APPLICATION_ERASE_SEQUENCE) and
+                    memcmp(payload, CCS811_APPLICATION_ERASE_SEQUENCE, length) == 0) {
+                    _application_valid = false;
+                    _application_verified = false;
+                    _erase_completed = false;
+                    _application_data_bytes = 0;
+                    _erase_done_us = now_us + (uint64_t)_config.erase_ms * 1000;
+                } else if (length) {
+                    _error.write_register_invalid = true;
+                }
+                return;
+            case APP_DATA:
+                if (length == sizeof(ccs811_application_data_t)) _application_data_bytes += length;
+                else if (length) _error.write_register_invalid = true;
+                return;
+            case APP_VERIFY:
+                _application_verified = false;
+                _verify_done_us = now_us + (uint64_t)_config.verify_ms * 1000;
+                return;
+            case APP_START:
+                if (_application_valid) {
+                    _application_mode = true;
+                    _measure_start_us = now_us;
+                    _sample_index = 0;
+                } else {
+                    _error.write_register_invalid = true;
+                }
+                return;
+            case STATUS:
+            case HW_ID:
+            case HW_VERSION:
+            case FW_BOOT_VERSION:
+            case FW_APP_VERSION:
+            case ERROR_ID:
+                if (length) _error.write_register_invalid = true;
+                return;
+            default:
+                _error.write_register_invalid = true;
+                return;
+        }
+    }
+
+    if (length == 0) return;  // Selects the register for the next read
+    switch (reg) {
+        case MEAS_MODE: {
+            ccs811_measure_config_t config;
+            config.raw = payload[0];
+            if (config.drive_mode > CCS811_CONSTANT_POWER_250MS) {
+                _error.measurement_mode_unsupported = true;
+                return;
+            }
+            config._reserved0 = 0;
+            config._reserved1 = 0;
+            _measure_config = config;
+            _measure_start_us = now_us;
+            _sample_index = 0;
+            _data_ready = false;
+            return;
+        }
+        case ENV_DATA:
+            memcpy(_environment, payload, length < sizeof(_environment) ? length : sizeof(_environment));
+            return;
+        case THRESHOLDS:
+            memcpy(_thresholds, payload, length < sizeof(_thresholds) ? length : sizeof(_thresholds));
+            return;
+        case BASELINE:
+            memcpy(_baseline, payload, length < sizeof(_baseline) ? length : sizeof(_baseline));
+            return;
+        default:
+            _error.write_register_invalid = true;
+            return;
+    }
+}
+
+/**
+ * Fill a read from the selected register. Bytes past the end of the register read as 0.
+ * @return Number of bytes supplied.
+ */
+uint8_t CCS811Simulator::read_register(uint8_t* data, uint8_t length) {
+    uint8_t content[8] = {};
+    uint8_t size = 0;
+    bool valid = true;
+
+    switch (_selected) {
+        case STATUS:
+            content[0] = get_status();
+            size = 1;
+            break;
+        case HW_ID:
+            content[0] = CCS811_HARDWARE_ID;
+            size = 1;
+            break;
+        case HW_VERSION:
+            content[0] = CCS811_SIMULATOR_HARDWARE_VERSION;
+            size = 1;
+            break;
+        case FW_BOOT_VERSION:
+            content[0] = CCS811_SIMULATOR_BOOT_VERSION >> 8;
+            content[1] = CCS811_SIMULATOR_BOOT_VERSION & 0xFF;
+            size = 2;
+            break;
+        case FW_APP_VERSION:
+            content[0] = CCS811_SIMULATOR_APPLICATION_VERSION >> 8;
+            content[1] = CCS811_SIMULATOR_APPLICATION_VERSION & 0xFF;
+            size = 2;
+            break;
+        case ERROR_ID:
+            content[0] = _error.raw;
+            size = 1;
+            _error.raw = 0;
+            break;
+        default:
+            valid = _application_mode;
+            break;
+    }
+
+    if (valid and size == 0) {
+        switch (_selected) {
+            case MEAS_MODE:
+                content[0] = _measure_config.raw;
+                size = 1;
+                break;
+            case ALG_RESULT_DATA:
+                content[0] = _eCO2 >> 8;
+                content[1] = _eCO2 & 0xFF;
+                content[2] = _eTVOC >> 8;
+                content[3] = _eTVOC & 0xFF;
+                content[4] = get_status();
+                content[5] = _error.raw;
+                content[6] = _raw >> 8;
+                content[7] = _raw & 0xFF;
+                size = 8;
+                _data_ready = false;
+                break;
+            case RAW_DATA:
+                content[0] = _raw >> 8;
+                content[1] = _raw & 0xFF;
+                size = 2;
+                if (_measure_config.drive_mode == CCS811_CONSTANT_POWER_250MS) _data_ready = false;
+                break;
+            case THRESHOLDS:
+                memcpy(content, _thresholds, sizeof(_thresholds));
+                size = sizeof(_thresholds);
+                break;
+            case BASELINE:
+                memcpy(content, _baseline, sizeof(_baseline));
+                size = sizeof(_baseline);
+                break;
+            default:
+                valid = false;
+                break;
+        }
+    }
+    if (not valid) _error.read_register_invalid = true;
+
+    memset(data, 0, length);
+    memcpy(data, content, length < size ? length : size);
+    return length;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Bring the sensor up to the current virtual time: finish flash operations and produce any samples that are due.
+ */
+void CCS811Simulator::update() {
+    uint64_t now_us = arduino_host_time_us();
+    if (_erase_done_us and now_us >= _erase_done_us) {
+        _erase_completed = true;
+        _erase_done_us = 0;
+    }
+    if (_verify_done_us and now_us >= _verify_done_us) {
+        _application_verified = true;
+        _application_valid = _application_data_bytes > 0;
+        _verify_done_us = 0;
+    }
+
+    uint64_t period = sample_period_us();
+    if (not _application_mode or period == 0 or now_us < _measure_start_us) return;
+
+    uint64_t due = (now_us - _measure_start_us) / period;
+    while (_sample_index < due) {
+        if (_data_ready) _stats.overwritten_samples++;
+        produce_sample();
+        _sample_index++;
+        _data_ready = true;
+        _stats.samples++;
+    }
+}
+
+/**
+ * Generate the next sample as a bounded random walk. ALG_RESULT_DATA is left alone in the raw-only drive mode.
+ */
+void CCS811Simulator::produce_sample() {
+    uint16_t eCO2 = _eCO2;
+    uint16_t eTVOC = _eTVOC;
+    if (_config.walk_step) {
+        int32_t step = (int32_t)(next_random() % (2 * _config.walk_step + 1)) - _config.walk_step;
+        int32_t level = (int32_t)eCO2 + step;
+        eCO2 = level < MINIMUM_ECO2 ? MINIMUM_ECO2 : level > MAXIMUM_ECO2 ? MAXIMUM_ECO2 : (uint16_t)level;
+        uint32_t tvoc = (uint32_t)(eCO2 - MINIMUM_ECO2) * 3 / 10 + next_random() % 5;
+        eTVOC = tvoc > MAXIMUM_ETVOC ? MAXIMUM_ETVOC : (uint16_t)tvoc;
+    }
+
+    if (_heater_fault) _error.heater_current_not_in_range = true;
+
+    uint16_t adc = 600 - (eTVOC > 1000 ? 1000 : eTVOC) / 2;
+    _raw = (uint16_t)(SENSOR_CURRENT_UA << 10) | adc;
+    if (_measure_config.drive_mode != CCS811_CONSTANT_POWER_250MS) {
+        _eCO2 = eCO2;
+        _eTVOC = eTVOC;
+    }
+}
+
+/**
+ * Time between samples in the current drive mode, including the configured clock error.
+ */
+uint64_t CCS811Simulator::sample_period_us() {
+    return (uint64_t)(ccs811_sample_period_ms(_measure_config.drive_mode) * 1000.0 * _config.period_scale + 0.5);
+}
+
+/**
+ * xorshift32; small, fast and reproducible from the seed.
+ */
+uint32_t CCS811Simulator::next_random() {
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return _random;
+}
@@ -0,0 +1,163 @@
+#ifndef CCS811_SIMULATOR_H
+#define CCS811_SIMULATOR_H
+
+#include <Wire.h>
+#include <stdint.h>
+#include "CCS811_driver.h"
+
+/**
+ * Behavioural model of a CCS811 for host tests and benchmarks, attached to a host TwoWire bus in place of the chip.
+ *
+ * Modelled: the register mailbox (a write of the register address selects what the next read returns), STATUS bits,
+ * boot vs application mode, MEAS_MODE sample timing per drive mode, data_ready set on each new sample and cleared by
+ * reading ALG_RESULT_DATA, the 8-byte ALG_RESULT_DATA and RAW_DATA layouts, ERROR_ID flags (cleared on read), BASELINE,
+ * ENV_DATA, THRESHOLDS, the firmware erase/data/verify sequence and software reset. Writes to invalid registers are
+ * acknowledged and flagged in ERROR_ID, as on the chip.
+ *
+ * Faults can be scripted at set times: NACK bursts, a stuck bus, a brown-out reset in the middle of a transaction and
+ * heater faults reported through ERROR_ID.
+ *
+ * Time comes from the host virtual clock. Samples are generated lazily when the sensor is next accessed, so an idle
+ * simulator costs nothing and thousands can share one core. All randomness comes from a per-instance seed, so runs are
+ * reproducible.
+ */
+
+const uint8_t CCS811_SIMULATOR_HARDWARE_VERSION = 0x12;
+const uint16_t CCS811_SIMULATOR_BOOT_VERSION = 0x1000;         // 1.0.0
+const uint16_t CCS811_SIMULATOR_APPLICATION_VERSION = 0x2000;  // 2.0.0
+
+typedef struct {
+    uint32_t seed;             // Seed for sample values and injected faults
+    float period_scale;        // Actual sample period relative to nominal, e.g. 0.987 for a sensor running 1.3% fast
+    uint16_t eCO2;             // Initial eCO2 in ppm
+    uint16_t eTVOC;            // Initial eTVOC in ppb
+    uint16_t walk_step;        // Largest eCO2 change between samples; 0 keeps the readings constant
+    uint16_t nack_per_mille;   // Chance that a transaction is not acknowledged, in 1/1000
+    uint32_t latency_us;       // Clock stretching added to every transaction; advances the virtual clock
+    uint32_t erase_ms;         // Time an APP_ERASE takes to complete
+    uint32_t verify_ms;        // Time an APP_VERIFY takes to complete
+} ccs811_simulator_config_t;
+
+const ccs811_simulator_config_t CCS811_DEFAULT_SIMULATOR_CONFIG = {1, 1.0f, 400, 0, 10, 0, 0, 300, 70};
+
+enum CCS811_SIMULATOR_FAULT {
+    CCS811_SIMULATOR_NACKS = 0,         // Transactions are not acknowledged at `parameter` per mille
+    CCS811_SIMULATOR_STUCK_BUS = 1,     // SDA held low: every transaction fails after a `parameter` microsecond timeout
+    CCS811_SIMULATOR_BROWN_OUT = 2,     // Next data transfer is cut short; the sensor resets and NACKs for the duration
+    CCS811_SIMULATOR_HEATER_FAULT = 3,  // ERROR_ID reports a heater current fault on every sample
+};
+
+/**
+ * One entry of a fault script. Times are on the host virtual clock.
+ */
+typedef struct {
+    uint32_t start_ms;     // Time the fault begins
+    uint32_t duration_ms;  // How long the fault lasts
+    uint8_t type;          // CCS811_SIMULATOR_FAULT
+    uint32_t parameter;    // Fault specific, see CCS811_SIMULATOR_FAULT
+} ccs811_simulator_fault_t;
+
+const uint8_t CCS811_SIMULATOR_MAX_FAULTS = 32;
+
+typedef struct {
+    uint32_t transactions;         // Write and read transactions addressed to the sensor
+    uint32_t nacks;                // Transactions that were not acknowledged
+    uint32_t samples;              // Samples produced
+    uint32_t overwritten_samples;  // Samples replaced by a newer one before ALG_RESULT_DATA was read
+    uint32_t brown_outs;           // Resets caused by a scripted brown-out
+    uint64_t busy_us;              // Virtual time spent in clock stretching and bus timeouts
+} ccs811_simulator_stats_t;
+
+class CCS811Simulator : public TwoWireDevice {
+   public:
+    CCS811Simulator(const ccs811_simulator_config_t& config = CCS811_DEFAULT_SIMULATOR_CONFIG);
+
+    uint8_t on_write(const uint8_t* data, size_t length) override;
+    uint8_t on_read(uint8_t* data, uint8_t length) override;
+
+    void power_on(bool application_mode = false);
+    void set_air_quality(uint16_t eCO2, uint16_t eTVOC);
+    void set_nack_rate(uint16_t per_mille) { _config.nack_per_mille = per_mille; }
+    void set_latency_us(uint32_t latency_us) { _config.latency_us = latency_us; }
+    void set_fault_script(const ccs811_simulator_fault_t* faults, uint8_t count);
+
+    bool is_interrupt_asserted();
+    bool is_application_mode() { return _application_mode; }
+    uint8_t get_drive_mode() { return _measure_config.drive_mode; }
+    uint8_t get_status();
+    uint8_t get_error() { return _error.raw; }
+    uint16_t get_eCO2() { return _eCO2; }
+    uint16_t get_eTVOC() { return _eTVOC; }
+    const uint8_t* get_environment() { return _environment; }
+    uint32_t get_application_data_bytes() { return _application_data_bytes; }
+    uint64_t get_next_sample_us();
+    ccs811_simulator_stats_t get_stats() { return _stats; }
+    void clear_stats() { _stats = {}; }
+
+   private:
+    typedef enum {
+        STATUS = 0x00,
+        MEAS_MODE = 0x01,
+        ALG_RESULT_DATA = 0x02,
+        RAW_DATA = 0x03,
+        ENV_DATA = 0x05,
+        THRESHOLDS = 0x10,
+        BASELINE = 0x11,
+        HW_ID = 0x20,
+        HW_VERSION = 0x21,
+        FW_BOOT_VERSION = 0x23,
+        FW_APP_VERSION = 0x24,
+        ERROR_ID = 0xE0,
+        APP_ERASE = 0xF1,
+        APP_DATA = 0xF2,
+        APP_VERIFY = 0xF3,
+        APP_START = 0xF4,
+        SW_RESET = 0xFF
+    } ccs811_sim_reg_t;
+
+    ccs811_simulator_config_t _config;
+    uint32_t _random;
+    ccs811_simulator_stats_t _stats = {};
+
+    const ccs811_simulator_fault_t* _faults = nullptr;
+    uint8_t _fault_count = 0;
+    uint32_t _faults_triggered = 0;
+    bool _brown_out_pending = false;
+    uint64_t _offline_until_us = 0;
+    uint64_t _brown_out_offline_us = 0;
+    bool _heater_fault = false;
+
+    bool _application_mode;
+    bool _application_valid;
+    bool _application_verified;
+    bool _erase_completed;
+    uint64_t _erase_done_us;
+    uint64_t _verify_done_us;
+    uint32_t _application_data_bytes;
+
+    uint8_t _selected;
+    ccs811_measure_config_t _measure_config;
+    ccs811_error_t _error;
+    bool _data_ready;
+    uint64_t _measure_start_us;
+    uint32_t _sample_index;
+
+    uint16_t _eCO2;
+    uint16_t _eTVOC;
+    uint16_t _raw;
+    uint8_t _baseline[2];
+    uint8_t _environment[4];
+    uint8_t _thresholds[4];
+
+    uint32_t next_random();
+    uint8_t check_transaction();
+    void apply_faults(uint64_t now_us, uint16_t& nack_per_mille, uint32_t& stuck_timeout_us);
+    void brown_out();
+    void update();
+    void produce_sample();
+    uint64_t sample_period_us();
+    void write_register(uint8_t reg, const uint8_t* payload, size_t length);
+    uint8_t read_register(uint8_t* data, uint8_t length);
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include "CCS811_trace.h"
+#include <stdio.h>
+#include <string.h>
+
+static_assert(sizeof(ccs811_trace_record_t) == CCS811_TRACE_RECORD_SIZE, "trace records are stored as 8 bytes");
+
+/**
+ * @param capacity: Bytes of trace to keep; records that do not fit are dropped and counted.
+ */
+CCS811TraceRecorder::CCS811TraceRecorder(size_t capacity) : _buffer(new uint8_t[capacity]), _capacity(capacity) {}
+
+CCS811TraceRecorder::~CCS811TraceRecorder() { delete[] _buffer; }
+
+/**
+ * Start recording a sensor's transactions. Replaces any trace callback the sensor had.
+ */
+void CCS811TraceRecorder::start(CCS811& sensor) { sensor.set_trace_callback(record, this); }
+
+/**
+ * Stop recording a sensor's transactions. The trace recorded so far is kept.
+ */
+void CCS811TraceRecorder::stop(CCS811& sensor) { sensor.set_trace_callback(nullptr); }
+
+void CCS811TraceRecorder::clear() {
+    _size = 0;
+    _records = 0;
+    _dropped = 0;
+}
+
+/**
+ * Write the trace to a file.
+ * @return True if the whole trace was written.
+ */
+bool CCS811TraceRecorder::save(const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (not file) return false;
+    bool written = fwrite(_buffer, 1, _size, file) == _size;
+    return fclose(file) == 0 and written;
+}
+
+void CCS811TraceRecorder::record(void* context, const ccs811_trace_record_t& record, const uint8_t* payload) {
+    CCS811TraceRecorder* recorder = static_cast<CCS811TraceRecorder*>(context);
+
+    size_t size = CCS811_TRACE_RECORD_SIZE + record.length;
+    if (recorder->_size + size > recorder->_capacity) {
+        recorder->_dropped++;
+        return;
+    }
+    memcpy(recorder->_buffer + recorder->_size, &record, CCS811_TRACE_RECORD_SIZE);
+    if (record.length) memcpy(recorder->_buffer + recorder->_size + CCS811_TRACE_RECORD_SIZE, payload, record.length);
+    recorder->_size += size;
+    recorder->_records++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @param trace: Recorded trace; must outlive the replay.
+ * @param size: Trace length in bytes.
+ */
+CCS811TraceReplay::CCS811TraceReplay(const uint8_t* trace, size_t size) : _trace(trace), _size(size) {}
+
+/**
+ * Answer a write transaction: either a register write, or the register address of a read that follows.
+ */
+uint8_t CCS811TraceReplay::on_write(const uint8_t* data, size_t length) {
+    _read_pending = false;
+    ccs811_trace_record_t record;
+    if (length == 0 or not peek(record) or record.reg != data[0]) {
+        _stats.mismatches++;
+        return TWO_WIRE_OTHER_ERROR;
+    }
+
+    if (record.direction == CCS811_TRACE_READ) {
+        if (length != 1) {
+            _stats.mismatches++;
+            return TWO_WIRE_OTHER_ERROR;
+        }
+        if (record.result == CCS811_BUS_NACK) {
+            consume(record);
+            return TWO_WIRE_ADDRESS_NACK;
+        }
+        _read_pending = true;
+        return TWO_WIRE_OK;
+    }
+
+    // A NACKed write transferred no payload, so only successful writes can be checked for length
+    if (record.result == CCS811_BUS_OK and record.length != length - 1) {
+        _stats.mismatches++;
+        return TWO_WIRE_OTHER_ERROR;
+    }
+    consume(record);
+    return record.result == CCS811_BUS_OK ? TWO_WIRE_OK : TWO_WIRE_DATA_NACK;
+}
+
+/**
+ * Answer a read transaction with the recorded payload, which is shorter than requested for a recorded short read.
+ */
+uint8_t CCS811TraceReplay::on_read(uint8_t* data, uint8_t length) {
+    ccs811_trace_record_t record;
+    if (not _read_pending or not peek(record)) {
+        _stats.mismatches++;
+        return 0;
+    }
+    _read_pending = false;
+
+    uint8_t supplied = record.length < length ? record.length : length;
+    memcpy(data, _trace + _position + CCS811_TRACE_RECORD_SIZE, supplied);
+    consume(record);
+    return supplied;
+}
+
+/**
+ * Restart the trace from its first record. With time following on, the clock is re-synced at the next transaction.
+ */
+void CCS811TraceReplay::rewind() {
+    _position = 0;
+    _read_pending = false;
+    _time_synced = false;
+    _stats.rewinds++;
+}
+
+/**
+ * Look at the next record, restarting the trace first if it has ended and looping is on.
+ * With time following on, advance the virtual clock to the time the recorded transaction ended.
+ * @return False if there is no complete record left.
+ */
+bool CCS811TraceReplay::peek(ccs811_trace_record_t& record) {
+    if (is_finished() and _loop and _size) rewind();
+    if (_position + CCS811_TRACE_RECORD_SIZE > _size) return false;
+    memcpy(&record, _trace + _position, CCS811_TRACE_RECORD_SIZE);
+    if (_position + CCS811_TRACE_RECORD_SIZE + record.length > _size) return false;
+
+    if (_follow_time) {
+        if (not _time_synced) {
+            _time_offset_ms = millis() - record.time_ms;
+            _time_synced = true;
+        }
+        uint32_t due_ms = record.time_ms + _time_offset_ms;
+        int32_t ahead_ms = (int32_t)(due_ms - millis());
+        if (ahead_ms > 0) arduino_host_advance_ms(ahead_ms);
+    }
+    return true;
+}
+
+void CCS811TraceReplay::consume(const ccs811_trace_record_t& record) {
+    _position += CCS811_TRACE_RECORD_SIZE + record.length;
+    _stats.transactions++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Read a trace file, e.g. one captured on a node or saved by CCS811TraceRecorder.
+ * @param path: File to read.
+ * @param buffer: Buffer to load the trace into.
+ * @param capacity: Buffer size.
+ * @param size: Set to the number of bytes loaded.
+ * @return False if the file cannot be read or does not fit in the buffer.
+ */
+bool ccs811_trace_load(const char* path, uint8_t* buffer, size_t capacity, size_t& size) {
+    FILE* file = fopen(path, "rb");
+    if (not file) return false;
+    size = fread(buffer, 1, capacity, file);
+    bool complete = feof(file) or fgetc(file) == EOF;
+    fclose(file);
+    return complete;
+}
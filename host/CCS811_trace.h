@@ -0,0 +1,95 @@
+#ifndef CCS811_TRACE_H
+#define CCS811_TRACE_H
+
+/**
+ * Binary bus traces: capture the driver's transactions and serve them back in place of the sensor.
+ *
+ * A trace is a sequence of ccs811_trace_record_t, each stored as its 8 bytes followed by `length` payload bytes. This
+ * is the byte stream a node produces by writing each record and payload from its trace callback to a serial port or
+ * file, so traces captured on the target load here unchanged (both AVR and x86 are little-endian).
+ *
+ * CCS811TraceReplay answers the driver the way the recorded sensor did: register, direction, result and read payload
+ * come from the trace, and the virtual clock can follow the recorded timestamps. The driver must issue the same
+ * transaction sequence as the recording; a transaction that does not match the next record is failed and counted.
+ */
+
+#include <Wire.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CCS811_driver.h"
+
+const size_t CCS811_TRACE_RECORD_SIZE = 8;
+
+/**
+ * Records drivers' transactions into a fixed-size buffer.
+ * Any number of recorders can run at once, and one recorder can record several sensors; each record carries the
+ * sensor's device address.
+ */
+class CCS811TraceRecorder {
+   public:
+    CCS811TraceRecorder(size_t capacity);
+    ~CCS811TraceRecorder();
+
+    void start(CCS811& sensor);
+    void stop(CCS811& sensor);
+    void clear();
+
+    const uint8_t* get_trace() { return _buffer; }
+    size_t get_size() { return _size; }
+    uint32_t get_records() { return _records; }
+    uint32_t get_dropped() { return _dropped; }
+    bool save(const char* path);
+
+   private:
+    static void record(void* context, const ccs811_trace_record_t& record, const uint8_t* payload);
+
+    uint8_t* _buffer;
+    size_t _capacity;
+    size_t _size = 0;
+    uint32_t _records = 0;
+    uint32_t _dropped = 0;
+
+    CCS811TraceRecorder(const CCS811TraceRecorder&);
+    CCS811TraceRecorder& operator=(const CCS811TraceRecorder&);
+};
+
+typedef struct {
+    uint32_t transactions;  // Transactions answered from the trace
+    uint32_t mismatches;    // Transactions that did not match the next record, or came after the end of the trace
+    uint32_t rewinds;       // Times the trace was restarted from the beginning
+} ccs811_trace_replay_stats_t;
+
+/**
+ * A TwoWire device that answers from a recorded trace of a single sensor.
+ */
+class CCS811TraceReplay : public TwoWireDevice {
+   public:
+    CCS811TraceReplay(const uint8_t* trace, size_t size);
+
+    uint8_t on_write(const uint8_t* data, size_t length) override;
+    uint8_t on_read(uint8_t* data, uint8_t length) override;
+
+    void set_follow_time(bool follow) { _follow_time = follow; }
+    void set_loop(bool loop) { _loop = loop; }
+    void rewind();
+    bool is_finished() { return _position >= _size; }
+    ccs811_trace_replay_stats_t get_stats() { return _stats; }
+
+   private:
+    const uint8_t* _trace;
+    size_t _size;
+    size_t _position = 0;
+    bool _follow_time = false;
+    bool _loop = false;
+    bool _read_pending = false;
+    bool _time_synced = false;
+    uint32_t _time_offset_ms = 0;  // Virtual clock minus recorded time, once synced
+    ccs811_trace_replay_stats_t _stats = {};
+
+    bool peek(ccs811_trace_record_t& record);
+    void consume(const ccs811_trace_record_t& record);
+};
+
+bool ccs811_trace_load(const char* path, uint8_t* buffer, size_t capacity, size_t& size);
+
+#endif
@@ -0,0 +1,54 @@
+#include "MockTwoWireDevice.h"
+#include <string.h>
+
+uint8_t MockTwoWireDevice::on_write(const uint8_t* data, size_t length) {
+    _writes++;
+    if (_nacks_pending) {
+        _nacks_pending--;
+        return TWO_WIRE_DATA_NACK;
+    }
+
+    memcpy(_last_write, data, length);
+    _last_write_length = length;
+    if (length == 0) return TWO_WIRE_OK;
+
+    _selected = data[0];
+    if (length > 1) memcpy(_registers[_selected], data + 1, length - 1);
+    return TWO_WIRE_OK;
+}
+
+uint8_t MockTwoWireDevice::on_read(uint8_t* data, uint8_t length) {
+    _reads++;
+    if (_nacks_pending) {
+        _nacks_pending--;
+        return 0;
+    }
+
+    if (length > MOCK_REGISTER_SIZE) length = MOCK_REGISTER_SIZE;
+    if (_short_reads_pending) {
+        _short_reads_pending--;
+        if (_short_read_length < length) length = _short_read_length;
+    }
+    memcpy(data, _registers[_selected], length);
+    return length;
+}
+
+/**
+ * Set the contents a read of a register returns.
+ */
+void MockTwoWireDevice::set_register(uint8_t reg, const uint8_t* data, uint8_t length) {
+    if (length > MOCK_REGISTER_SIZE) length = MOCK_REGISTER_SIZE;
+    memcpy(_registers[reg], data, length);
+}
+
+void MockTwoWireDevice::set_register(uint8_t reg, uint8_t value) { set_register(reg, &value, 1); }
+
+/**
+ * Make the next reads return fewer bytes than requested.
+ * @param count: Number of reads to shorten.
+ * @param length: Bytes each shortened read returns.
+ */
+void MockTwoWireDevice::shorten_next_reads(uint8_t count, uint8_t length) {
+    _short_reads_pending = count;
+    _short_read_length = length;
+}
@@ -0,0 +1,44 @@
+#ifndef MOCK_TWO_WIRE_DEVICE_H
+#define MOCK_TWO_WIRE_DEVICE_H
+
+/**
+ * Register-file mock for a host TwoWire bus.
+ * A write stores its first byte as the selected register and any following bytes as that register's contents; a read
+ * returns the selected register's contents. NACKs and short reads can be queued to exercise error paths, and every
+ * write is kept for inspection.
+ */
+
+#include "Wire.h"
+
+const uint8_t MOCK_REGISTER_SIZE = BUFFER_LENGTH;
+
+class MockTwoWireDevice : public TwoWireDevice {
+   public:
+    uint8_t on_write(const uint8_t* data, size_t length) override;
+    uint8_t on_read(uint8_t* data, uint8_t length) override;
+
+    void set_register(uint8_t reg, const uint8_t* data, uint8_t length);
+    void set_register(uint8_t reg, uint8_t value);
+    const uint8_t* get_register(uint8_t reg) { return _registers[reg]; }
+
+    void fail_next_transactions(uint8_t count) { _nacks_pending = count; }
+    void shorten_next_reads(uint8_t count, uint8_t length);
+
+    uint32_t get_writes() { return _writes; }
+    uint32_t get_reads() { return _reads; }
+    const uint8_t* get_last_write() { return _last_write; }
+    size_t get_last_write_length() { return _last_write_length; }
+
+   private:
+    uint8_t _registers[256][MOCK_REGISTER_SIZE] = {};
+    uint8_t _selected = 0;
+    uint8_t _nacks_pending = 0;
+    uint8_t _short_reads_pending = 0;
+    uint8_t _short_read_length = 0;
+    uint32_t _writes = 0;
+    uint32_t _reads = 0;
+    uint8_t _last_write[BUFFER_LENGTH] = {};
+    size_t _last_write_length = 0;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "Wire.h"
+
+TwoWire Wire;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Start queuing a write transaction.
+ * @param address: 7-bit address of the target device.
+ */
+void TwoWire::beginTransmission(uint8_t address) {
+    _address = address;
+    _transmit_length = 0;
+    _transmit_overflow = false;
+}
+
+/**
+ * Queue a byte for the current write transaction.
+ * @return 1 if the byte was queued, 0 if the transmit buffer is full.
+ */
+size_t TwoWire::write(uint8_t data) {
+    if (_transmit_length >= BUFFER_LENGTH) {
+        _transmit_overflow = true;
+        return 0;
+    }
+    _transmit[_transmit_length++] = data;
+    return 1;
+}
+
+/**
+ * Queue several bytes for the current write transaction.
+ * @return Number of bytes queued.
+ */
+size_t TwoWire::write(const uint8_t* data, size_t length) {
+    size_t written = 0;
+    while (written < length and write(data[written])) written++;
+    return written;
+}
+
+/**
+ * Send the queued write transaction to the device.
+ * @return TWO_WIRE_RESULT.
+ */
+uint8_t TwoWire::endTransmission(uint8_t) {
+    if (_transmit_overflow) return TWO_WIRE_DATA_TOO_LONG;
+    TwoWireDevice* device = find(_address);
+    if (not device) return TWO_WIRE_ADDRESS_NACK;
+    return device->on_write(_transmit, _transmit_length);
+}
+
+/**
+ * Read bytes from a device into the receive buffer.
+ * @param address: 7-bit address of the target device.
+ * @param quantity: Number of bytes to request, at most BUFFER_LENGTH.
+ * @return Number of bytes received.
+ */
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t) {
+    if (quantity > BUFFER_LENGTH) quantity = BUFFER_LENGTH;
+    _receive_index = 0;
+    _receive_length = 0;
+
+    TwoWireDevice* device = find(address);
+    if (device) _receive_length = device->on_read(_receive, quantity);
+    if (_receive_length > quantity) _receive_length = quantity;
+    return _receive_length;
+}
+
+/**
+ * Get the number of received bytes not read yet.
+ */
+int TwoWire::available() { return _receive_length - _receive_index; }
+
+/**
+ * Take the next received byte.
+ * @return Byte value, or -1 if none is left.
+ */
+int TwoWire::read() { return _receive_index < _receive_length ? _receive[_receive_index++] : -1; }
+
+/**
+ * Look at the next received byte without taking it.
+ * @return Byte value, or -1 if none is left.
+ */
+int TwoWire::peek() { return _receive_index < _receive_length ? _receive[_receive_index] : -1; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Attach a device to the bus. A device already at the address is replaced.
+ * @param address: 7-bit address the device answers to.
+ * @param device: Device model; must outlive its attachment.
+ * @return False if the bus already holds TWO_WIRE_MAX_DEVICES devices.
+ */
+bool TwoWire::attach(uint8_t address, TwoWireDevice* device) {
+    for (uint8_t i = 0; i < _device_count; i++) {
+        if (_devices[i].address == address) {
+            _devices[i].device = device;
+            return true;
+        }
+    }
+    if (_device_count >= TWO_WIRE_MAX_DEVICES) return false;
+    _devices[_device_count].address = address;
+    _devices[_device_count].device = device;
+    _device_count++;
+    return true;
+}
+
+/**
+ * Remove the device at an address from the bus.
+ */
+void TwoWire::detach(uint8_t address) {
+    for (uint8_t i = 0; i < _device_count; i++) {
+        if (_devices[i].address == address) {
+            _devices[i] = _devices[--_device_count];
+            return;
+        }
+    }
+}
+
+TwoWireDevice* TwoWire::find(uint8_t address) {
+    for (uint8_t i = 0; i < _device_count; i++) {
+        if (_devices[i].address == address) return _devices[i].device;
+    }
+    return nullptr;
+}
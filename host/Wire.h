@@ -0,0 +1,93 @@
+#ifndef TWO_WIRE_H
+#define TWO_WIRE_H
+
+/**
+ * Host stand-in for the Arduino Wire library.
+ * Transactions are buffered exactly as on hardware and handed whole to the device attached at the target address, so
+ * anything that models a bus device (a mock, a simulator, a trace replay) plugs in behind the same TwoWire the driver
+ * uses on the target. A transaction to an address without a device is not acknowledged.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Arduino.h"  // The real Wire.h pulls in the Arduino core as well
+
+#define BUFFER_LENGTH 32
+
+const uint8_t TWO_WIRE_MAX_DEVICES = 4;
+
+enum TWO_WIRE_RESULT {
+    TWO_WIRE_OK = 0,              // Transaction acknowledged
+    TWO_WIRE_DATA_TOO_LONG = 1,   // More bytes were queued than the transmit buffer holds
+    TWO_WIRE_ADDRESS_NACK = 2,    // No device acknowledged the address
+    TWO_WIRE_DATA_NACK = 3,       // The device did not acknowledge a data byte
+    TWO_WIRE_OTHER_ERROR = 4,     // Bus error, e.g. SDA held low
+};
+
+/**
+ * Something attached to a host TwoWire bus.
+ */
+class TwoWireDevice {
+   public:
+    virtual ~TwoWireDevice() {}
+
+    /**
+     * Handle a write transaction.
+     * @param data: Bytes sent after the address, starting with the register address.
+     * @param length: Number of bytes sent.
+     * @return TWO_WIRE_RESULT as returned by endTransmission().
+     */
+    virtual uint8_t on_write(const uint8_t* data, size_t length) = 0;
+
+    /**
+     * Handle a read transaction.
+     * @param data: Buffer to fill.
+     * @param length: Number of bytes requested.
+     * @return Number of bytes supplied; fewer than requested models a short read, 0 a NACK.
+     */
+    virtual uint8_t on_read(uint8_t* data, uint8_t length) = 0;
+};
+
+class TwoWire {
+   public:
+    void begin() {}
+    void setClock(uint32_t clock_hz) { _clock_hz = clock_hz; }
+
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t length);
+    uint8_t endTransmission(uint8_t stop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t stop = true);
+    int available();
+    int read();
+    int peek();
+
+    // Host only
+    bool attach(uint8_t address, TwoWireDevice* device);
+    void detach(uint8_t address);
+    uint32_t get_clock() { return _clock_hz; }
+
+   private:
+    typedef struct {
+        uint8_t address;
+        TwoWireDevice* device;
+    } attachment_t;
+
+    attachment_t _devices[TWO_WIRE_MAX_DEVICES] = {};
+    uint8_t _device_count = 0;
+    uint32_t _clock_hz = 100000;
+
+    uint8_t _address = 0;
+    uint8_t _transmit[BUFFER_LENGTH];
+    uint8_t _transmit_length = 0;
+    bool _transmit_overflow = false;
+    uint8_t _receive[BUFFER_LENGTH];
+    uint8_t _receive_length = 0;
+    uint8_t _receive_index = 0;
+
+    TwoWireDevice* find(uint8_t address);
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef AVR_PGMSPACE_H
+#define AVR_PGMSPACE_H
+
+// Hosts have a single address space, so program memory is ordinary memory.
+
+#include <string.h>
+
+#define PROGMEM
+#define memcpy_P memcpy
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define pgm_read_float(address) (*(const float*)(address))
+
+#endif
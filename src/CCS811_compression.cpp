@@ -0,0 +1,169 @@
+#include "CCS811_compression.h"
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t zigzag_encode(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+
+static int32_t zigzag_decode(uint32_t value) { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
+/**
+ * Write an unsigned integer as a little-endian base-128 varint.
+ * @return Number of bytes written (at most 5).
+ */
+static uint8_t write_varint(uint8_t* output, uint32_t value) {
+    uint8_t length = 0;
+    while (value >= 0x80) {
+        output[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    output[length++] = (uint8_t)value;
+    return length;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Create an encoder writing into a buffer.
+ * @param buffer: Destination for the encoded stream.
+ * @param capacity: Size of the buffer in bytes.
+ * @param keyframe_interval: Number of samples between keyframes (1 makes every sample a keyframe).
+ */
+CCS811SampleEncoder::CCS811SampleEncoder(uint8_t* buffer, size_t capacity, uint16_t keyframe_interval)
+    : _buffer(buffer), _capacity(capacity), _keyframe_interval(keyframe_interval ? keyframe_interval : 1) {
+    reset();
+}
+
+/**
+ * Discard all encoded samples and start again at the beginning of the buffer.
+ */
+void CCS811SampleEncoder::reset() {
+    _size = 0;
+    _sample_count = 0;
+    _keyframe_offset = 0;
+    _previous_interval = 0;
+}
+
+/**
+ * Encode a sample at the end of the stream.
+ * Samples must be appended in time order.
+ * @param sample: Sample to encode.
+ * @return True if the sample was added, false if it did not fit in the remaining buffer.
+ */
+bool CCS811SampleEncoder::append(const ccs811_sample_t& sample) {
+    uint8_t encoded[CCS811_MAX_ENCODED_SAMPLE_SIZE];
+    uint8_t length = 0;
+    bool keyframe = (_sample_count % _keyframe_interval) == 0;
+    int32_t interval = 0;
+
+    if (keyframe) {
+        length += write_varint(encoded + length, sample.time_ms);
+        length += write_varint(encoded + length, sample.eCO2);
+        length += write_varint(encoded + length, sample.eTVOC);
+    } else {
+        interval = (int32_t)(sample.time_ms - _previous.time_ms);
+        length += write_varint(encoded + length, zigzag_encode(interval - _previous_interval));
+        length += write_varint(encoded + length, zigzag_encode((int32_t)sample.eCO2 - _previous.eCO2));
+        length += write_varint(encoded + length, zigzag_encode((int32_t)sample.eTVOC - _previous.eTVOC));
+    }
+
+    if (_size + length > _capacity) return false;
+
+    if (keyframe) _keyframe_offset = _size;
+    memcpy(_buffer + _size, encoded, length);
+    _size += length;
+    _sample_count++;
+    _previous = sample;
+    _previous_interval = interval;
+    return true;
+}
+
+/**
+ * Get the number of bytes of encoded data.
+ * @return Encoded stream size in bytes.
+ */
+size_t CCS811SampleEncoder::size() { return _size; }
+
+/**
+ * Get the number of samples encoded since the last reset.
+ * @return Sample count.
+ */
+uint32_t CCS811SampleEncoder::get_sample_count() { return _sample_count; }
+
+/**
+ * Get the offset of the most recent keyframe, for building a random-access index.
+ * @return Byte offset of the latest keyframe in the buffer.
+ */
+size_t CCS811SampleEncoder::get_keyframe_offset() { return _keyframe_offset; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Create a decoder over an encoded stream.
+ * @param buffer: Encoded stream.
+ * @param size: Size of the encoded stream in bytes.
+ * @param keyframe_interval: Keyframe interval used when encoding.
+ */
+CCS811SampleDecoder::CCS811SampleDecoder(const uint8_t* buffer, size_t size, uint16_t keyframe_interval)
+    : _buffer(buffer), _size(size), _keyframe_interval(keyframe_interval ? keyframe_interval : 1) {
+    seek(0);
+}
+
+/**
+ * Restart decoding at a keyframe.
+ * @param keyframe_offset: Byte offset of a keyframe, e.g. from CCS811SampleEncoder::get_keyframe_offset().
+ */
+void CCS811SampleDecoder::seek(size_t keyframe_offset) {
+    _position = keyframe_offset;
+    _sample_count = 0;
+    _previous_interval = 0;
+}
+
+/**
+ * Decode the next sample from the stream.
+ * @param sample: Container to decode the sample into.
+ * @return True if a sample was decoded, false at the end of the stream or on truncated or corrupt data. On failure the
+ * decoder stays at the start of the sample, so a later call cannot resume in the middle of it.
+ */
+bool CCS811SampleDecoder::next(ccs811_sample_t& sample) {
+    size_t start = _position;
+    uint32_t time;
+    uint32_t eCO2;
+    uint32_t eTVOC;
+    if (not read_varint(time) or not read_varint(eCO2) or not read_varint(eTVOC)) {
+        _position = start;
+        return false;
+    }
+
+    bool keyframe = (_sample_count % _keyframe_interval) == 0;
+    if (keyframe) {
+        sample.time_ms = time;
+        sample.eCO2 = (uint16_t)eCO2;
+        sample.eTVOC = (uint16_t)eTVOC;
+        _previous_interval = 0;
+    } else {
+        _previous_interval += zigzag_decode(time);
+        sample.time_ms = _previous.time_ms + _previous_interval;
+        sample.eCO2 = (uint16_t)(_previous.eCO2 + zigzag_decode(eCO2));
+        sample.eTVOC = (uint16_t)(_previous.eTVOC + zigzag_decode(eTVOC));
+    }
+
+    _sample_count++;
+    _previous = sample;
+    return true;
+}
+
+/**
+ * Read one varint from the current position.
+ * @param value: Container for the decoded value.
+ * @return True if a complete varint was read.
+ */
+bool CCS811SampleDecoder::read_varint(uint32_t& value) {
+    value = 0;
+    for (uint8_t shift = 0; shift < 35 and _position < _size; shift += 7) {
+        uint8_t byte = _buffer[_position++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (not(byte & 0x80)) return true;
+    }
+    return false;
+}
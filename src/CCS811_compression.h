@@ -0,0 +1,66 @@
+#ifndef CCS811_COMPRESSION_H
+#define CCS811_COMPRESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "CCS811_processing.h"
+
+const uint16_t CCS811_DEFAULT_KEYFRAME_INTERVAL = 64;
+const uint8_t CCS811_MAX_ENCODED_SAMPLE_SIZE = 11;  // 5 byte time varint + 2 * 3 byte value varints
+
+///////////////////////////////////////////////////////////////////////////////
+// SAMPLE STREAM ENCODING
+
+/**
+ * Encodes samples into a caller-supplied buffer.
+ * Every `keyframe_interval`-th sample is a keyframe holding absolute values; the others hold the zigzag varint
+ * delta-of-delta of the timestamp and the zigzag varint deltas of eCO2 and eTVOC. Decoding can start at any keyframe.
+ */
+class CCS811SampleEncoder {
+   public:
+    CCS811SampleEncoder(uint8_t* buffer, size_t capacity,
+                        uint16_t keyframe_interval = CCS811_DEFAULT_KEYFRAME_INTERVAL);
+
+    bool append(const ccs811_sample_t& sample);
+    void reset();
+
+    size_t size();
+    uint32_t get_sample_count();
+    size_t get_keyframe_offset();
+
+   private:
+    uint8_t* _buffer;
+    size_t _capacity;
+    size_t _size;
+    uint16_t _keyframe_interval;
+    uint32_t _sample_count;
+    size_t _keyframe_offset;
+    ccs811_sample_t _previous;
+    int32_t _previous_interval;
+};
+
+/**
+ * Decodes a buffer written by CCS811SampleEncoder.
+ * The keyframe interval must match the one used for encoding.
+ */
+class CCS811SampleDecoder {
+   public:
+    CCS811SampleDecoder(const uint8_t* buffer, size_t size,
+                        uint16_t keyframe_interval = CCS811_DEFAULT_KEYFRAME_INTERVAL);
+
+    bool next(ccs811_sample_t& sample);
+    void seek(size_t keyframe_offset);
+
+   private:
+    const uint8_t* _buffer;
+    size_t _size;
+    size_t _position;
+    uint16_t _keyframe_interval;
+    uint32_t _sample_count;
+    ccs811_sample_t _previous;
+    int32_t _previous_interval;
+
+    bool read_varint(uint32_t& value);
+};
+
+#endif
@@ -1,35 +1,48 @@
 #include "CCS811_driver.h"
 #include <ArduinoLog.h>
+#include <string.h>
 
 ////////////////////////////////////////////////////////////////////////////////
 
 /**
  * Start the air quality sensor.
+ * @param device_address: I2C address of the sensor.
+ * @param bus: I2C bus the sensor is attached to.
  * @return True if the device was started and is communicating successfully.
  */
-bool CCS811::begin(uint8_t device_address) {
+bool CCS811::begin(uint8_t device_address, TwoWire& bus) {
     _device_address = device_address;
+    _bus = &bus;
     return comms_check();
 }
 
 /**
  * Check if the device is communicating properly.
- * The hardware ID is checked from the device's registers.
+ * The hardware ID is checked from the device's registers. Failed reads are retried according to the comms retry
+ * policy; see set_comms_retry_policy().
  * @return True if the hardware ID matches the expected value.
  */
 bool CCS811::comms_check() {
     ccs811_hardware_id_t id;
+    id.raw = 0;
 
     bool success = read(id);
     uint8_t retries = 0;
-    while (not success and retries < 10) {
+    uint32_t wait = _comms_retry_delay_ms;
+    while (not success and retries < _comms_retries) {
+        delay_ms(wait);
+        _bus_stats.comms_retry_ms += wait;
+        if (_comms_exponential_backoff and wait < CCS811_MAX_COMMS_RETRY_DELAY_MS) {
+            wait = wait * 2 < CCS811_MAX_COMMS_RETRY_DELAY_MS ? wait * 2 : CCS811_MAX_COMMS_RETRY_DELAY_MS;
+        }
+
         success = read(id);
         retries++;
-        delay(10);
+        _bus_stats.comms_retries++;
         Log.trace(F("AQ - id retrieval failed; retrying (%d)\n"), retries);
     }
 
-    return id.raw == CCS811_HARDWARE_ID;
+    return success and id.raw == CCS811_HARDWARE_ID;
 }
 
 /**
@@ -42,42 +55,96 @@ bool CCS811::comms_check() {
  */
 bool CCS811::write(uint8_t* input, ccs811_reg_t address, uint8_t length) {
     bool result = true;
-    Wire.beginTransmission(_device_address);
-    Wire.write(address);
+    _bus->beginTransmission(_device_address);
+    _bus->write(address);
     for (size_t i = 0; i < length; i++) {
-        Wire.write(input[i]);
+        _bus->write(input[i]);
         Log.trace(F("AQ Sent [%X] >> %X\n"), input[i]);
     }
 
-    if (Wire.endTransmission() != 0) {
+    _bus_stats.transfers++;
+    _bus_stats.bytes_written += length + 1;
+
+    if (_bus->endTransmission() != 0) {
+        _last_error = CCS811_BUS_NACK;
+        _bus_stats.nacks++;
         result = false;
+    } else {
+        _last_error = CCS811_BUS_OK;
     }
+    trace(CCS811_TRACE_WRITE, address, input, result ? length : 0);
     return result;
 }
 
 /**
  * Read a specified number of bytes using the I2C bus.
+ * A read that returns fewer bytes than requested is treated as a failure (CCS811_BUS_SHORT_READ) and the whole
+ * transaction is repeated up to the configured short read retry budget.
  * @param output: The buffer in which to store the read values.
  * @param address: Register address to read (or starting address in burst reads)
  * @param length: Number of bytes to read.
+ * @return: True if all requested bytes were received.
  */
 bool CCS811::read(uint8_t* output, ccs811_reg_t address, uint8_t length) {
-    bool result = true;
-    Wire.beginTransmission(_device_address);
-    Wire.write(address);
-    if (Wire.endTransmission() != 0)
-        result = false;
+    uint8_t retries = 0;
+    while (true) {
+        _bus->beginTransmission(_device_address);
+        _bus->write(address);
+        _bus_stats.transfers++;
+        _bus_stats.bytes_written++;
+        if (_bus->endTransmission() != 0) {
+            _last_error = CCS811_BUS_NACK;
+            _bus_stats.nacks++;
+            trace(CCS811_TRACE_READ, address, output, 0);
+            return false;
+        }
+
+        _bus->requestFrom(_device_address, length);
+        uint8_t received = 0;
+        for (; (received < length) and _bus->available(); received++) {
+            output[received] = _bus->read();
+            Log.trace(F("AQ Received [%X] >> %X\n"), output[received]);
+        }
+        _bus_stats.transfers++;
+        _bus_stats.bytes_read += received;
+
+        if (received == length) {
+            _last_error = CCS811_BUS_OK;
+            trace(CCS811_TRACE_READ, address, output, received);
+            return true;
+        }
 
-    else  // OK, all worked, keep going
-    {
-        Wire.requestFrom(_device_address, length);
-        for (size_t i = 0; (i < length) and Wire.available(); i++) {
-            uint8_t c = Wire.read();
-            output[i] = c;
-            Log.trace(F("AQ Received [%X] >> %X\n"), output[i]);
+        _bus_stats.short_reads++;
+        _last_error = CCS811_BUS_SHORT_READ;
+        trace(CCS811_TRACE_READ, address, output, received);
+        Log.trace(F("AQ - short read of register %X (%d of %d bytes)\n"), address, received, length);
+        if (retries >= _short_read_retries) {
+            return false;
         }
+        retries++;
+        _bus_stats.short_read_retries++;
     }
-    return result;
+}
+
+/**
+ * Pass a completed bus transaction to the trace callback, if one is set.
+ * The result recorded is the current value of the last error.
+ * @param direction: Whether the payload was written to or read from the device.
+ * @param address: Register address of the transaction.
+ * @param payload: Bytes transferred.
+ * @param length: Number of bytes transferred.
+ */
+void CCS811::trace(CCS811_TRACE_DIRECTION direction, ccs811_reg_t address, const uint8_t* payload, uint8_t length) {
+    if (not _trace) return;
+
+    ccs811_trace_record_t record;
+    record.time_ms = get_time_ms();
+    record.device_address = _device_address;
+    record.reg = address;
+    record.length = length;
+    record.direction = direction;
+    record.result = _last_error;
+    _trace(_trace_context, record, payload);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -109,7 +176,11 @@ bool CCS811::read(ccs811_co2_thresholds_t& thresholds) {
  * Read the measured eCO2 level from the sensor.
  * @param data: Container to read data into.
  */
-bool CCS811::read(ccs811_eCO2_data_t& data) { return read((uint8_t*)&data, ALG_RESULT_DATA, sizeof(data)); }
+bool CCS811::read(ccs811_eCO2_data_t& data) {
+    bool success = read(data.raw, ALG_RESULT_DATA, sizeof(data));
+    swap_endianess(data.raw, sizeof(data));
+    return success;
+}
 
 /**
  * Read the latest eTVOC measurement from the sensor.
@@ -117,29 +188,93 @@ bool CCS811::read(ccs811_eCO2_data_t& data) { return read((uint8_t*)&data, ALG_R
  */
 bool CCS811::read(ccs811_eTVOC_data_t& data) {
     ccs811_air_quality_data_t output;
-    bool success = read(output.raw, ALG_RESULT_DATA, sizeof(output.raw));
+    bool success = read(output);
     data = output.eTVOC_reading;
     return success;
 }
 
 /**
  * Read the raw data from the sensor.
+ * The register is big-endian on the bus; bytes are swapped so the ADC and current fields decode on the host.
  * @param data: Container to read the data into.
  */
-bool CCS811::read(ccs811_raw_data_t& data) { return read((uint8_t*)&data, RAW_DATA, sizeof(data)); }
+bool CCS811::read(ccs811_raw_data_t& data) {
+    bool success = read(data.raw, RAW_DATA, sizeof(data));
+    swap_endianess(data.raw, sizeof(data));
+    return success;
+}
 
 /**
  * Read the latest air quality measurements from the sensor.
+ * The sensor sends eCO2 then eTVOC, most significant byte first; the buffer is reversed to match the container.
  * @param data: Container to read data into.
  */
-bool CCS811::read(ccs811_air_quality_data_t& data) { return read(data.raw, ALG_RESULT_DATA, sizeof(data)); }
+bool CCS811::read(ccs811_air_quality_data_t& data) {
+    bool success = read(data.raw, ALG_RESULT_DATA, sizeof(data));
+    swap_endianess(data.raw, sizeof(data));
+    return success;
+}
+
+/**
+ * Read the latest air quality measurements only if the sensor has a sample that has not been read yet.
+ * eCO2, eTVOC and STATUS are read in one burst and data_ready is checked from that burst. Reading ALG_RESULT_DATA
+ * clears data_ready on the sensor, so each sample is reported as new exactly once.
+ * @param data: Container to read data into. Left untouched unless new data was read.
+ * @return CCS811_READ_NEW_DATA, CCS811_READ_NO_NEW_DATA, or CCS811_READ_ERROR if the bus transaction failed.
+ */
+CCS811_READ_RESULT CCS811::read_new(ccs811_air_quality_data_t& data) {
+    uint8_t buffer[sizeof(data) + 1];
+    if (not read(buffer, ALG_RESULT_DATA, sizeof(buffer))) return CCS811_READ_ERROR;
+
+    ccs811_status_t status;
+    status.raw = buffer[sizeof(data)];
+    if (not status.data_ready) return CCS811_READ_NO_NEW_DATA;
+
+    memcpy(data.raw, buffer, sizeof(data));
+    swap_endianess(data.raw, sizeof(data));
+    _sample_sequence++;
+    return CCS811_READ_NEW_DATA;
+}
+
+/**
+ * Read all data only if the sensor has a sample that has not been read yet.
+ * Status is checked from the same burst as the measurements.
+ * @param data: Container to read data into. Left untouched unless new data was read.
+ * @return CCS811_READ_NEW_DATA, CCS811_READ_NO_NEW_DATA, or CCS811_READ_ERROR if the bus transaction failed.
+ */
+CCS811_READ_RESULT CCS811::read_new(ccs811_all_data_t& data) {
+    uint8_t buffer[sizeof(data)];
+    if (not read(buffer, ALG_RESULT_DATA, sizeof(buffer))) return CCS811_READ_ERROR;
+
+    ccs811_status_t status;
+    status.raw = buffer[4];  // STATUS follows eCO2 and eTVOC on the bus
+    if (not status.data_ready) return CCS811_READ_NO_NEW_DATA;
+
+    memcpy(data.raw, buffer, sizeof(data));
+    swap_endianess(data.raw, sizeof(data));
+    _sample_sequence++;
+    return CCS811_READ_NEW_DATA;
+}
+
+/**
+ * Get the number of new samples returned by read_new().
+ * Consumers can compare sequence numbers to detect samples they have already processed.
+ * @return Sequence number of the latest new sample (0 before the first).
+ */
+uint32_t CCS811::get_sample_sequence() { return _sample_sequence; }
 
 /**
  * Read the latest data from the sensor.
  * All measurements, including raw data, status, and error registers are included.
+ * The sensor sends the fields in reverse order of the container, most significant byte first; the whole buffer is
+ * reversed so every field decodes on the host.
  * @param data: Container to read data into.
  */
-bool CCS811::read(ccs811_all_data_t& data) { return read(data.raw, ALG_RESULT_DATA, sizeof(data)); }
+bool CCS811::read(ccs811_all_data_t& data) {
+    bool success = read(data.raw, ALG_RESULT_DATA, sizeof(data));
+    swap_endianess(data.raw, sizeof(data));
+    return success;
+}
 
 /**
  * Read the sensor baseline calibration? data from the sensor.
@@ -242,7 +377,9 @@ bool CCS811::write(ccs811_application_start_t code) { return write(&code.raw, AP
  * @param sequence: Erase sequence to be written to the register.
  * @return True if the sequence was written successfully.
  */
-bool CCS811::write(ccs811_application_erase_t sequence) { return write(sequence, APP_ERASE, sizeof(sequence)); }
+bool CCS811::write(ccs811_application_erase_t sequence) {
+    return write(sequence, APP_ERASE, sizeof(ccs811_application_erase_t));
+}
 
 /**
  * Reset the device.
@@ -310,7 +447,7 @@ uint16_t CCS811::get_eTVOC() {
  */
 bool CCS811::reset() {
     ccs811_reset_t sequence;
-    memcpy_P(sequence.raw, CCS811_RESET_SEQUENCE, sizeof(CCS811_RESET_SEQUENCE));
+    memcpy(sequence.raw, CCS811_RESET_SEQUENCE, sizeof(CCS811_RESET_SEQUENCE));
     return write(sequence);
 }
 
@@ -321,7 +458,7 @@ bool CCS811::reset() {
  */
 bool CCS811::start_application_erase() {
     ccs811_application_erase_t sequence;
-    memcpy_P(sequence, CCS811_APPLICATION_ERASE_SEQUENCE, sizeof(CCS811_APPLICATION_ERASE_SEQUENCE));
+    memcpy(sequence, CCS811_APPLICATION_ERASE_SEQUENCE, sizeof(CCS811_APPLICATION_ERASE_SEQUENCE));
     return write(sequence);
 }
 
@@ -348,6 +485,81 @@ bool CCS811::start_application_mode() {
     return write(code);
 }
 
+/**
+ * Get the result of the most recent bus transaction.
+ * @return CCS811_BUS_OK, or the class of error that caused the last read or write to fail.
+ */
+CCS811_BUS_ERROR CCS811::get_last_error() { return _last_error; }
+
+/**
+ * Get the bus transfer and error counters accumulated since the last clear.
+ * @return Copy of the current bus statistics.
+ */
+ccs811_bus_stats_t CCS811::get_bus_stats() { return _bus_stats; }
+
+/**
+ * Reset all bus counters to zero.
+ */
+void CCS811::clear_bus_stats() { _bus_stats = {}; }
+
+/**
+ * Set how many times a short read is repeated before the read is reported as failed.
+ * @param retries: Number of additional attempts after the first short read. 0 disables retrying.
+ */
+void CCS811::set_short_read_retries(uint8_t retries) { _short_read_retries = retries; }
+
+/**
+ * Set how comms_check() retries a failed hardware ID read.
+ * @param retries: Maximum number of additional reads after the first failure.
+ * @param delay_ms: Wait before the first retry in milliseconds.
+ * @param exponential_backoff: True to double the wait after every retry, up to CCS811_MAX_COMMS_RETRY_DELAY_MS; false
+ *                             for a fixed wait.
+ */
+void CCS811::set_comms_retry_policy(uint8_t retries, uint16_t delay_ms, bool exponential_backoff) {
+    _comms_retries = retries;
+    _comms_retry_delay_ms = delay_ms;
+    _comms_exponential_backoff = exponential_backoff;
+}
+
+/**
+ * Set a callback that receives every bus transaction, including its payload and timing.
+ * Read retries are reported as separate transactions. Used to capture bus traces for later replay.
+ * @param callback: Function to call after each transaction, or nullptr to disable tracing.
+ * @param context: Passed unchanged to the callback, e.g. the object collecting the trace.
+ */
+void CCS811::set_trace_callback(ccs811_trace_fn_t callback, void* context) {
+    _trace = callback;
+    _trace_context = context;
+}
+
+/**
+ * Route all driver timing through the given clock.
+ * Useful for running the driver against a simulated bus on virtual time.
+ * @param clock: Function returning the current time in milliseconds, or nullptr to use millis().
+ * @param delay: Function that waits for the given milliseconds, or nullptr to use delay().
+ */
+void CCS811::set_clock(ccs811_clock_fn_t clock, ccs811_delay_fn_t delay) {
+    _clock = clock;
+    _delay = delay;
+}
+
+/**
+ * Get the current time from the driver's clock.
+ * @return Time in milliseconds.
+ */
+uint32_t CCS811::get_time_ms() { return _clock ? _clock() : millis(); }
+
+/**
+ * Wait using the driver's clock.
+ * @param duration: Time to wait in milliseconds.
+ */
+void CCS811::delay_ms(uint32_t duration) {
+    if (_delay)
+        _delay(duration);
+    else
+        delay(duration);
+}
+
 /**
  * Swap the endianness of a buffer.
  * Swap will occur in place.
@@ -358,4 +570,38 @@ void swap_endianess(uint8_t* buffer, size_t size) {
         buffer[i] = buffer[size - 1 - i];
         buffer[size - 1 - i] = temp;
     }
-}
\ No newline at end of file
+}
+
+/**
+ * Get the nominal time between new samples for a drive mode.
+ * The sensor sets the data_ready flag once per period while measuring.
+ * @param drive_mode: Drive mode as written to MEAS_MODE.
+ * @return Sample period in milliseconds, or 0 if the mode does not produce samples.
+ */
+uint32_t ccs811_sample_period_ms(uint8_t drive_mode) {
+    switch (drive_mode) {
+        case CCS811_CONSTANT_POWER_1SEC:
+            return CCS811_CONSTANT_POWER_1SEC_SAMPLE_PERIOD_MS;
+        case CCS811_PULSED_10SEC:
+            return CCS811_PULSED_10SEC_SAMPLE_PERIOD_MS;
+        case CCS811_PULSED_60SEC:
+            return CCS811_PULSED_60SEC_SAMPLE_PERIOD_MS;
+        case CCS811_CONSTANT_POWER_250MS:
+            return CCS811_CONSTANT_POWER_250MS_SAMPLE_PERIOD_MS;
+        default:
+            return CCS811_IDLE_SAMPLE_PERIOD_MS;
+    }
+}
+
+/**
+ * Estimate the time the bus was occupied by the transfers recorded in a set of bus statistics.
+ * Each transfer costs a START/STOP and an address byte; each byte costs 8 data bits and an ACK.
+ * @param stats: Bus statistics to estimate from.
+ * @param clock_hz: I2C clock frequency, e.g. 100000 or 400000.
+ * @return Modelled bus time in microseconds, or 0 if the clock frequency is 0.
+ */
+uint32_t ccs811_bus_time_us(const ccs811_bus_stats_t& stats, uint32_t clock_hz) {
+    if (clock_hz == 0) return 0;
+    uint64_t bits = (uint64_t)stats.transfers * (2 + 9) + ((uint64_t)stats.bytes_written + stats.bytes_read) * 9;
+    return (uint32_t)(bits * 1000000 / clock_hz);
+}
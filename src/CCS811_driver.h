@@ -2,10 +2,70 @@
 #define CCS811_DRIVER_H
 
 #include <Wire.h>
+#include <stddef.h>
 #include <stdint.h>
 
 const uint8_t CCS811_HARDWARE_ID = 0x81;
 const uint8_t CCS811_DEFAULT_I2C_ADDRESS = 0x5A;
+const uint8_t CCS811_DEFAULT_SHORT_READ_RETRIES = 0;
+const uint8_t CCS811_DEFAULT_COMMS_RETRIES = 10;
+const uint16_t CCS811_DEFAULT_COMMS_RETRY_DELAY_MS = 10;
+const uint32_t CCS811_MAX_COMMS_RETRY_DELAY_MS = 60000;  // Exponential backoff stops doubling here
+
+///////////////////////////////////////////////////////////////////////////////
+// BUS
+
+enum CCS811_BUS_ERROR {
+    CCS811_BUS_OK = 0,          // Last transaction completed successfully
+    CCS811_BUS_NACK = 1,        // Device did not acknowledge the register address or data
+    CCS811_BUS_SHORT_READ = 2,  // Device returned fewer bytes than requested
+};
+
+typedef struct {
+    uint32_t transfers;           // Bus transfers started (each START condition)
+    uint32_t bytes_written;       // Bytes sent to the device, including register addresses
+    uint32_t bytes_read;          // Bytes received from the device
+    uint16_t nacks;               // Transactions that were not acknowledged by the device
+    uint16_t short_reads;         // Read attempts that returned fewer bytes than requested
+    uint16_t short_read_retries;  // Read attempts repeated after a short read
+    uint16_t comms_retries;       // Hardware ID reads repeated by comms_check()
+    uint32_t comms_retry_ms;      // Time spent waiting between comms_check() retries
+} ccs811_bus_stats_t;
+
+enum CCS811_READ_RESULT {
+    CCS811_READ_ERROR = 0,        // Bus transaction failed
+    CCS811_READ_NEW_DATA = 1,     // A sample that had not been read before was returned
+    CCS811_READ_NO_NEW_DATA = 2,  // The sensor has no new sample since the last read; nothing was decoded
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TRACE
+
+enum CCS811_TRACE_DIRECTION {
+    CCS811_TRACE_WRITE = 0,
+    CCS811_TRACE_READ = 1,
+};
+
+/**
+ * One bus transaction as seen by the driver. Packs into 8 bytes so records can be streamed or stored directly as a
+ * binary trace, followed by `length` payload bytes. The device address tells apart sensors sharing one trace.
+ */
+typedef struct {
+    uint32_t time_ms;        // Driver clock at the end of the transaction
+    uint8_t device_address;  // I2C address of the sensor
+    uint8_t reg;             // Register address that was read or written
+    uint8_t length;          // Payload bytes actually transferred
+    uint8_t direction : 1;   // CCS811_TRACE_DIRECTION
+    uint8_t result : 7;      // CCS811_BUS_ERROR
+} ccs811_trace_record_t;
+
+typedef void (*ccs811_trace_fn_t)(void* context, const ccs811_trace_record_t& record, const uint8_t* payload);
+
+///////////////////////////////////////////////////////////////////////////////
+// CLOCK
+
+typedef uint32_t (*ccs811_clock_fn_t)();       // Returns the current time in milliseconds
+typedef void (*ccs811_delay_fn_t)(uint32_t);  // Blocks (or advances virtual time) for the given milliseconds
 
 ///////////////////////////////////////////////////////////////////////////////
 // STATUS
@@ -45,6 +105,12 @@ enum CCS811_DRIVE_MODE {
     CCS811_CONSTANT_POWER_250MS = 4
 };
 
+const uint32_t CCS811_IDLE_SAMPLE_PERIOD_MS = 0;
+const uint32_t CCS811_CONSTANT_POWER_1SEC_SAMPLE_PERIOD_MS = 1000;
+const uint32_t CCS811_PULSED_10SEC_SAMPLE_PERIOD_MS = 10000;
+const uint32_t CCS811_PULSED_60SEC_SAMPLE_PERIOD_MS = 60000;
+const uint32_t CCS811_CONSTANT_POWER_250MS_SAMPLE_PERIOD_MS = 250;
+
 typedef union {
     uint8_t raw;
     struct {
@@ -268,7 +334,7 @@ typedef union {
 
 class CCS811 {
    public:
-    bool begin(uint8_t device_address = CCS811_DEFAULT_I2C_ADDRESS);
+    bool begin(uint8_t device_address = CCS811_DEFAULT_I2C_ADDRESS, TwoWire& bus = Wire);
     bool comms_check();
 
     bool read(ccs811_status_t&);
@@ -286,6 +352,10 @@ class CCS811 {
     bool read(ccs811_firmware_application_version_t&);
     bool read(ccs811_error_t&);
 
+    CCS811_READ_RESULT read_new(ccs811_air_quality_data_t&);
+    CCS811_READ_RESULT read_new(ccs811_all_data_t&);
+    uint32_t get_sample_sequence();
+
     bool write(ccs811_measure_config_t);
     bool write(ccs811_environmental_data_t);
     bool write(ccs811_co2_thresholds_t);
@@ -304,6 +374,18 @@ class CCS811 {
     bool start_application_verify();
     bool start_application_mode();
 
+    CCS811_BUS_ERROR get_last_error();
+    ccs811_bus_stats_t get_bus_stats();
+    void clear_bus_stats();
+    void set_short_read_retries(uint8_t retries);
+    void set_comms_retry_policy(uint8_t retries, uint16_t delay_ms, bool exponential_backoff = false);
+
+    void set_trace_callback(ccs811_trace_fn_t callback, void* context = nullptr);
+
+    void set_clock(ccs811_clock_fn_t clock, ccs811_delay_fn_t delay);
+    uint32_t get_time_ms();
+    void delay_ms(uint32_t duration);
+
    private:
     typedef enum {
         STATUS = 0x00,
@@ -326,14 +408,29 @@ class CCS811 {
         SW_RESET = 0xFF
     } ccs811_reg_t;
     uint8_t _device_address;
+    TwoWire* _bus = &Wire;
+    uint8_t _short_read_retries = CCS811_DEFAULT_SHORT_READ_RETRIES;
+    uint8_t _comms_retries = CCS811_DEFAULT_COMMS_RETRIES;
+    uint16_t _comms_retry_delay_ms = CCS811_DEFAULT_COMMS_RETRY_DELAY_MS;
+    bool _comms_exponential_backoff = false;
+    CCS811_BUS_ERROR _last_error = CCS811_BUS_OK;
+    ccs811_bus_stats_t _bus_stats = {};
+    ccs811_clock_fn_t _clock = nullptr;
+    ccs811_delay_fn_t _delay = nullptr;
+    ccs811_trace_fn_t _trace = nullptr;
+    void* _trace_context = nullptr;
+    uint32_t _sample_sequence = 0;
 
     bool read(uint8_t* output, ccs811_reg_t address, uint8_t length = 1);
     bool write(uint8_t* input, ccs811_reg_t address, uint8_t length = 1);
+    void trace(CCS811_TRACE_DIRECTION direction, ccs811_reg_t address, const uint8_t* payload, uint8_t length);
 
     bool write(ccs811_application_erase_t);
     bool write(ccs811_reset_t);
 };
 
 void swap_endianess(uint8_t* buffer, size_t size);
+uint32_t ccs811_sample_period_ms(uint8_t drive_mode);
+uint32_t ccs811_bus_time_us(const ccs811_bus_stats_t& stats, uint32_t clock_hz);
 
 #endif
@@ -0,0 +1,265 @@
+#include "CCS811_filters.h"
+#include <math.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint16_t to_integer(int32_t fixed) { return (uint16_t)((fixed + 128) >> 8); }
+
+/**
+ * Convert a reading to fixed point, clamped to the sensor's range.
+ * With values below 2^21 and weights of at most 256, every difference times weight stays below 2^29.
+ */
+static int32_t to_fixed(uint16_t sample) {
+    return (int32_t)(sample < CCS811_MAX_eCO2 ? sample : CCS811_MAX_eCO2) << 8;
+}
+
+/**
+ * IIR step on a raw fixed-point value, shared by the single and batch forms.
+ */
+static int32_t iir_step(int32_t value, uint16_t sample, uint16_t alpha) {
+    int32_t target = to_fixed(sample);
+    if (value == CCS811_FILTER_EMPTY) return target;
+    int32_t weight = alpha < 256 ? alpha : 256;
+    return value + (((target - value) * weight) >> 8);
+}
+
+/**
+ * Kalman step on raw fixed-point values, shared by the single and batch forms.
+ * Gains are computed with 8 fractional bits, at most 256, so with readings clamped by to_fixed() and variances by
+ * CCS811_MAX_VARIANCE every product fits in 32 bits.
+ */
+static void kalman_step(int32_t& estimate, uint32_t& variance, uint16_t sample, const ccs811_kalman_config_t& config) {
+    int32_t measurement = to_fixed(sample);
+    if (estimate == CCS811_FILTER_EMPTY) {
+        estimate = measurement;
+        variance = config.measurement_noise;
+        return;
+    }
+
+    variance += config.process_noise;
+    if (variance > CCS811_MAX_VARIANCE) variance = CCS811_MAX_VARIANCE;
+
+    uint32_t total = variance + config.measurement_noise;
+    int32_t gain = total ? (int32_t)((variance << 8) / total) : 256;
+    estimate += ((measurement - estimate) * gain) >> 8;
+    variance -= (variance * (uint32_t)gain) >> 8;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Smooth a sample with a first-order IIR filter.
+ * The first sample initialises the filter.
+ * @param state: Filter state for this sensor, initially CCS811_IIR_INITIAL_STATE.
+ * @param sample: New reading.
+ * @param alpha: Weight of the new reading in 1/256 steps (256 = no smoothing, 16 = time constant of ~16 samples).
+ * Larger values are treated as 256.
+ * @return Smoothed value.
+ */
+uint16_t ccs811_iir_update(ccs811_iir_state_t& state, uint16_t sample, uint16_t alpha) {
+    state.value = iir_step(state.value, sample, alpha);
+    return to_integer(state.value);
+}
+
+/**
+ * Smooth a sample with a one-dimensional Kalman filter.
+ * The first sample initialises the filter.
+ * @param state: Filter state for this sensor, initially CCS811_KALMAN_INITIAL_STATE.
+ * @param config: Noise model.
+ * @param sample: New reading.
+ * @return Filtered value.
+ */
+uint16_t ccs811_kalman_update(ccs811_kalman_state_t& state, const ccs811_kalman_config_t& config, uint16_t sample) {
+    kalman_step(state.estimate, state.variance, sample, config);
+    return to_integer(state.estimate);
+}
+
+/**
+ * Smooth one new sample from each of many sensors with IIR filters.
+ * State is held as a structure of arrays: element i of each array belongs to sensor i.
+ * @param values: Filter values, CCS811_FILTER_EMPTY for sensors that have not been sampled yet.
+ * @param samples: New readings.
+ * @param outputs: Smoothed values.
+ * @param count: Number of sensors.
+ * @param alpha: Weight of the new readings in 1/256 steps, at most 256.
+ */
+void ccs811_iir_update_batch(int32_t* values, const uint16_t* samples, uint16_t* outputs, size_t count,
+                             uint16_t alpha) {
+    for (size_t i = 0; i < count; i++) {
+        values[i] = iir_step(values[i], samples[i], alpha);
+        outputs[i] = to_integer(values[i]);
+    }
+}
+
+/**
+ * Filter one new sample from each of many sensors with Kalman filters sharing a noise model.
+ * State is held as a structure of arrays: element i of each array belongs to sensor i.
+ * @param estimates: Filter estimates, CCS811_FILTER_EMPTY for sensors that have not been sampled yet.
+ * @param variances: Filter variances.
+ * @param samples: New readings.
+ * @param outputs: Filtered values.
+ * @param count: Number of sensors.
+ * @param config: Noise model.
+ */
+void ccs811_kalman_update_batch(int32_t* estimates, uint32_t* variances, const uint16_t* samples, uint16_t* outputs,
+                                size_t count, const ccs811_kalman_config_t& config) {
+    for (size_t i = 0; i < count; i++) {
+        kalman_step(estimates[i], variances[i], samples[i], config);
+        outputs[i] = to_integer(estimates[i]);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Create an anomaly detector.
+ * @param config: Detection thresholds.
+ */
+CCS811AnomalyDetector::CCS811AnomalyDetector(const ccs811_anomaly_config_t& config) : _config(config) { reset(); }
+
+/**
+ * Forget all previous readings.
+ */
+void CCS811AnomalyDetector::reset() {
+    _mean = 0;
+    _variance = 0;
+    _sample_count = 0;
+    _previous = 0;
+    _unchanged_count = 0;
+    _anomalies = CCS811_ANOMALY_NONE;
+}
+
+/**
+ * Check a new reading and update the running statistics.
+ * @param value: New reading.
+ * @return True if the set of active anomalies changed with this reading.
+ */
+bool CCS811AnomalyDetector::update(uint16_t value) {
+    uint8_t anomalies = CCS811_ANOMALY_NONE;
+
+    if (_sample_count == 0) {
+        _mean = value;
+    } else {
+        float deviation = value - _mean;
+        float spread = _variance > _config.minimum_deviation * _config.minimum_deviation
+                           ? _variance
+                           : _config.minimum_deviation * _config.minimum_deviation;
+        if (_sample_count >= _config.warmup_samples and
+            deviation * deviation >= _config.spike_threshold * _config.spike_threshold * spread) {
+            anomalies |= CCS811_ANOMALY_SPIKE;
+        }
+
+        uint16_t step = value > _previous ? value - _previous : _previous - value;
+        if (_config.maximum_step and step > _config.maximum_step) anomalies |= CCS811_ANOMALY_RATE;
+
+        if (step != 0) {
+            _unchanged_count = 0;
+        } else if (_unchanged_count < 0xFFFF) {
+            _unchanged_count++;
+        }
+        if (_config.stuck_samples and _unchanged_count >= _config.stuck_samples) anomalies |= CCS811_ANOMALY_STUCK;
+
+        _mean += _config.alpha * deviation;
+        _variance = (1 - _config.alpha) * (_variance + _config.alpha * deviation * deviation);
+    }
+
+    if (_sample_count < 0xFFFFFFFF) _sample_count++;
+    _previous = value;
+
+    bool changed = anomalies != _anomalies;
+    _anomalies = anomalies;
+    return changed;
+}
+
+/**
+ * Get the anomalies active after the latest reading.
+ * @return Bitmask of CCS811_ANOMALY flags.
+ */
+uint8_t CCS811AnomalyDetector::get_anomalies() { return _anomalies; }
+
+/**
+ * Get the running mean of the readings.
+ * @return Exponentially weighted mean.
+ */
+float CCS811AnomalyDetector::get_mean() { return _mean; }
+
+/**
+ * Get the running standard deviation of the readings.
+ * @return Exponentially weighted standard deviation.
+ */
+float CCS811AnomalyDetector::get_deviation() { return sqrtf(_variance); }
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Twice the area of the triangle formed by two samples and a point, used to rank downsampling candidates.
+ * @param a: Previously kept sample; times are measured relative to it to keep float precision.
+ * @param b: Candidate sample.
+ * @param c_time_ms: Time of the third point relative to a.
+ * @param c_value: Value of the third point.
+ * @param field: Series the values are taken from.
+ * @return Doubled triangle area.
+ */
+float ccs811_triangle_area(const ccs811_sample_t& a, const ccs811_sample_t& b, float c_time_ms, float c_value,
+                           CCS811_FIELD field) {
+    float a_value = ccs811_sample_value(a, field);
+    float b_time_ms = b.time_ms - a.time_ms;
+    float b_value = ccs811_sample_value(b, field);
+    return fabsf(b_time_ms * (c_value - a_value) - c_time_ms * (b_value - a_value));
+}
+
+/**
+ * Downsample a stored series to a target number of points with Largest-Triangle-Three-Buckets.
+ * Each call only touches its own input and output, so separate series can be downsampled on separate threads.
+ * @param input: Samples in time order.
+ * @param count: Number of input samples.
+ * @param output: Array of at least `points` samples.
+ * @param points: Number of samples to keep (at least 3 to downsample; fewer copies the start of the input).
+ * @param field: Series whose shape is preserved.
+ * @return Number of samples written.
+ */
+size_t ccs811_downsample(const ccs811_sample_t* input, size_t count, ccs811_sample_t* output, size_t points,
+                         CCS811_FIELD field) {
+    if (points >= count or points < 3) {
+        size_t copied = points < count ? points : count;
+        for (size_t i = 0; i < copied; i++) output[i] = input[i];
+        return copied;
+    }
+
+    float bucket_size = (float)(count - 2) / (points - 2);
+    size_t kept = 0;
+    size_t anchor = 0;
+    output[kept++] = input[0];
+
+    for (size_t bucket = 0; bucket < points - 2; bucket++) {
+        size_t start = 1 + (size_t)(bucket * bucket_size);
+        size_t end = 1 + (size_t)((bucket + 1) * bucket_size);
+        size_t next_start = end;
+        size_t next_end = bucket + 2 < points - 2 ? 1 + (size_t)((bucket + 2) * bucket_size) : count;
+        if (next_end > count) next_end = count;
+
+        float time_ms = 0;
+        float value = 0;
+        for (size_t i = next_start; i < next_end; i++) {
+            time_ms += input[i].time_ms - input[anchor].time_ms;
+            value += ccs811_sample_value(input[i], field);
+        }
+        time_ms /= next_end - next_start;
+        value /= next_end - next_start;
+
+        size_t best = start;
+        float best_area = -1;
+        for (size_t i = start; i < end; i++) {
+            float area = ccs811_triangle_area(input[anchor], input[i], time_ms, value, field);
+            if (area > best_area) {
+                best_area = area;
+                best = i;
+            }
+        }
+        output[kept++] = input[best];
+        anchor = best;
+    }
+
+    output[kept++] = input[count - 1];
+    return kept;
+}
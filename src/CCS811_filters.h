@@ -0,0 +1,210 @@
+#ifndef CCS811_FILTERS_H
+#define CCS811_FILTERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "CCS811_processing.h"
+
+const int32_t CCS811_FILTER_EMPTY = -1;          // State value of a filter that has not seen a sample yet
+const uint32_t CCS811_MAX_VARIANCE = 1UL << 23;  // Variances are clamped here to keep fixed-point products in range
+
+///////////////////////////////////////////////////////////////////////////////
+// SMOOTHING
+
+/**
+ * First-order IIR (exponential moving average) filter state.
+ * Integer only: the smoothed value is held with 8 fractional bits and alpha is in 1/256 steps. Readings above
+ * CCS811_MAX_eCO2 are clamped to it, as are readings given to the Kalman filter.
+ */
+typedef struct {
+    int32_t value;  // Smoothed value * 256, or CCS811_FILTER_EMPTY
+} ccs811_iir_state_t;
+
+const ccs811_iir_state_t CCS811_IIR_INITIAL_STATE = {CCS811_FILTER_EMPTY};
+
+/**
+ * One-dimensional Kalman filter for a slowly varying level observed with noise.
+ * Noise variances are in (ppm or ppb)^2 and at most CCS811_MAX_VARIANCE. A larger process noise follows changes faster;
+ * a larger measurement noise smooths harder.
+ */
+typedef struct {
+    uint32_t process_noise;      // Expected variance of the true level between samples
+    uint32_t measurement_noise;  // Variance of the sensor noise
+} ccs811_kalman_config_t;
+
+typedef struct {
+    int32_t estimate;   // Estimated level * 256, or CCS811_FILTER_EMPTY
+    uint32_t variance;  // Variance of the estimate
+} ccs811_kalman_state_t;
+
+const ccs811_kalman_state_t CCS811_KALMAN_INITIAL_STATE = {CCS811_FILTER_EMPTY, 0};
+
+uint16_t ccs811_iir_update(ccs811_iir_state_t& state, uint16_t sample, uint16_t alpha);
+uint16_t ccs811_kalman_update(ccs811_kalman_state_t& state, const ccs811_kalman_config_t& config, uint16_t sample);
+
+void ccs811_iir_update_batch(int32_t* values, const uint16_t* samples, uint16_t* outputs, size_t count,
+                             uint16_t alpha);
+void ccs811_kalman_update_batch(int32_t* estimates, uint32_t* variances, const uint16_t* samples, uint16_t* outputs,
+                                size_t count, const ccs811_kalman_config_t& config);
+
+///////////////////////////////////////////////////////////////////////////////
+// ANOMALY DETECTION
+
+enum CCS811_ANOMALY {
+    CCS811_ANOMALY_NONE = 0,
+    CCS811_ANOMALY_SPIKE = 1,  // Reading is far outside the recent distribution (EWMA z-score)
+    CCS811_ANOMALY_STUCK = 2,  // Reading has not changed for too many samples
+    CCS811_ANOMALY_RATE = 4,   // Reading changed by more than the allowed step since the previous sample
+};
+
+typedef struct {
+    float alpha;              // EWMA weight of each new sample for the running mean and variance
+    float spike_threshold;    // z-score at or above which a reading is a spike
+    float minimum_deviation;  // Floor for the standard deviation, so quiet signals do not flag tiny changes
+    uint16_t warmup_samples;  // Samples before spike detection starts
+    uint16_t stuck_samples;   // Stuck after stuck_samples + 1 identical consecutive readings; 0 disables
+    uint16_t maximum_step;    // Largest allowed change between consecutive readings; 0 disables
+} ccs811_anomaly_config_t;
+
+const ccs811_anomaly_config_t CCS811_DEFAULT_eTVOC_ANOMALY_CONFIG = {0.05, 4.0, 5.0, 20, 60, 200};
+
+/**
+ * Streaming spike, stuck-sensor and rate-of-change detector for one series.
+ * Holds a fixed few bytes per sensor. update() reports when the set of active anomalies changes, so only transitions
+ * need to be sent upstream instead of every reading.
+ */
+class CCS811AnomalyDetector {
+   public:
+    CCS811AnomalyDetector(const ccs811_anomaly_config_t& config = CCS811_DEFAULT_eTVOC_ANOMALY_CONFIG);
+
+    bool update(uint16_t value);
+    void reset();
+
+    uint8_t get_anomalies();
+    float get_mean();
+    float get_deviation();
+
+   private:
+    ccs811_anomaly_config_t _config;
+    float _mean;
+    float _variance;
+    uint32_t _sample_count;
+    uint16_t _previous;
+    uint16_t _unchanged_count;
+    uint8_t _anomalies;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// DOWNSAMPLING
+
+float ccs811_triangle_area(const ccs811_sample_t& a, const ccs811_sample_t& b, float c_time_ms, float c_value,
+                           CCS811_FIELD field);
+size_t ccs811_downsample(const ccs811_sample_t* input, size_t count, ccs811_sample_t* output, size_t points,
+                         CCS811_FIELD field);
+
+/**
+ * Streaming Largest-Triangle-Three-Buckets downsampler.
+ * Keeps one sample out of every BUCKET, choosing the one that forms the largest triangle with the previously kept
+ * sample and the average of the following bucket, so peaks survive where plain decimation would drop them. The first
+ * and last samples are always kept. Memory is two buckets of samples.
+ */
+template <uint16_t BUCKET>
+class CCS811Downsampler {
+    static_assert(BUCKET > 0, "Downsampling bucket must hold at least one sample");
+
+   public:
+    CCS811Downsampler(CCS811_FIELD field = CCS811_FIELD_eCO2) : _field(field) { reset(); }
+
+    /**
+     * Add the next sample of the series.
+     * @param sample: New sample, in time order.
+     * @param output: Set to the kept sample when one is selected.
+     * @return True if a sample was kept and written to output.
+     */
+    bool add(const ccs811_sample_t& sample, ccs811_sample_t& output) {
+        if (not _has_anchor) {
+            _anchor = sample;
+            _has_anchor = true;
+            output = sample;
+            return true;
+        }
+        if (_next_count == 0 and _candidate_count < BUCKET) {
+            candidates()[_candidate_count++] = sample;
+            return false;
+        }
+
+        next()[_next_count++] = sample;
+        if (_next_count < BUCKET) return false;
+
+        output = select(next(), _next_count);
+        _anchor = output;
+        _candidate_bucket ^= 1;
+        _candidate_count = _next_count;
+        _next_count = 0;
+        return true;
+    }
+
+    /**
+     * Select the remaining samples at the end of the series.
+     * The last bucket of candidates is ranked against the last sample, so a peak in it is kept along with the end.
+     * @param output: Array of at least 2 samples to write kept samples to.
+     * @return Number of samples written.
+     */
+    uint8_t flush(ccs811_sample_t* output) {
+        uint8_t kept = 0;
+        if (_next_count > 0) {
+            output[kept++] = select(next(), _next_count);
+            output[kept++] = next()[_next_count - 1];
+        } else if (_candidate_count > 0) {
+            const ccs811_sample_t& last = candidates()[_candidate_count - 1];
+            ccs811_sample_t selected = select(&last, 1);
+            if (selected.time_ms != last.time_ms) output[kept++] = selected;
+            output[kept++] = last;
+        }
+        reset();
+        return kept;
+    }
+
+    void reset() {
+        _has_anchor = false;
+        _candidate_bucket = 0;
+        _candidate_count = 0;
+        _next_count = 0;
+    }
+
+   private:
+    CCS811_FIELD _field;
+    ccs811_sample_t _buckets[2][BUCKET];
+    ccs811_sample_t _anchor;
+    bool _has_anchor;
+    uint8_t _candidate_bucket;
+    uint16_t _candidate_count;
+    uint16_t _next_count;
+
+    ccs811_sample_t* candidates() { return _buckets[_candidate_bucket]; }
+    ccs811_sample_t* next() { return _buckets[_candidate_bucket ^ 1]; }
+
+    ccs811_sample_t select(const ccs811_sample_t* following, uint16_t following_count) {
+        float time_ms = 0;
+        float value = 0;
+        for (uint16_t i = 0; i < following_count; i++) {
+            time_ms += following[i].time_ms - _anchor.time_ms;
+            value += ccs811_sample_value(following[i], _field);
+        }
+        time_ms /= following_count;
+        value /= following_count;
+
+        uint16_t best = 0;
+        float best_area = -1;
+        for (uint16_t i = 0; i < _candidate_count; i++) {
+            float area = ccs811_triangle_area(_anchor, candidates()[i], time_ms, value, _field);
+            if (area > best_area) {
+                best_area = area;
+                best = i;
+            }
+        }
+        return candidates()[best];
+    }
+};
+
+#endif
@@ -0,0 +1,176 @@
+#include "CCS811_fusion.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sort a short array in place. Insertion sort is the fastest choice for the handful of sensors in a room.
+ */
+static void sort(uint16_t* values, uint8_t count) {
+    for (uint8_t i = 1; i < count; i++) {
+        uint16_t value = values[i];
+        uint8_t j = i;
+        for (; j > 0 and values[j - 1] > value; j--) values[j] = values[j - 1];
+        values[j] = value;
+    }
+}
+
+/**
+ * Median of a sorted array, rounded down.
+ */
+static uint16_t sorted_median(const uint16_t* values, uint8_t count) {
+    return count % 2 ? values[count / 2] : (uint16_t)(((uint32_t)values[count / 2 - 1] + values[count / 2]) / 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Derive a fusion weight from the sensor's status and error registers.
+ * @param status: Status from the same read as the reading.
+ * @param error: Error flags from the same read as the reading.
+ * @return 0 if the reading should not be used, 255 for a fully healthy sensor, less for degraded sensors.
+ */
+uint8_t ccs811_sensor_health(ccs811_status_t status, ccs811_error_t error) {
+    if (not status.firmware_is_in_application_mode) return 0;
+    if (error.heater_current_not_in_range or error.heater_voltage_incorrectly_applied) return 0;
+    if (error.maximum_sensor_resistance_exceeded) return 64;
+    if (status.error_has_occurred) return 128;
+    return 255;
+}
+
+/**
+ * Fuse time-aligned readings from several sensors in one room into one robust value.
+ * Readings more than `outlier_threshold` scaled median absolute deviations from the median are rejected; the rest are
+ * averaged weighted by sensor health. If every reading is rejected, the fused value is the median.
+ * @param values: One reading per sensor.
+ * @param health: One weight per sensor, e.g. from ccs811_sensor_health(). Sensors with weight 0 are ignored.
+ * @param count: Number of sensors, at most CCS811_MAX_FUSED_SENSORS.
+ * @param fused: Container to write the fused reading into.
+ * @param config: Outlier rejection parameters.
+ * @return True if at least one healthy reading was available.
+ */
+bool ccs811_fuse(const uint16_t* values, const uint8_t* health, uint8_t count, ccs811_fused_sample_t& fused,
+                 const ccs811_fusion_config_t& config) {
+    if (count > CCS811_MAX_FUSED_SENSORS) count = CCS811_MAX_FUSED_SENSORS;
+
+    uint16_t sorted[CCS811_MAX_FUSED_SENSORS];
+    uint8_t healthy = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (health[i]) sorted[healthy++] = values[i];
+    }
+    fused.inliers = 0;
+    if (healthy == 0) return false;
+
+    sort(sorted, healthy);
+    uint16_t median = sorted_median(sorted, healthy);
+
+    for (uint8_t i = 0; i < healthy; i++) sorted[i] = sorted[i] > median ? sorted[i] - median : median - sorted[i];
+    sort(sorted, healthy);
+    float deviation = sorted_median(sorted, healthy) * 1.4826f;  // Scales MAD to a standard deviation
+    if (deviation < config.minimum_deviation) deviation = config.minimum_deviation;
+    float limit = config.outlier_threshold * deviation;
+
+    uint32_t weighted_sum = 0;
+    uint32_t total_weight = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (not health[i]) continue;
+        uint16_t distance = values[i] > median ? values[i] - median : median - values[i];
+        if (distance > limit) continue;
+        weighted_sum += (uint32_t)values[i] * health[i];
+        total_weight += health[i];
+        fused.inliers++;
+    }
+
+    // A threshold below one deviation can reject every reading; the median is then the best estimate left
+    fused.median = median;
+    fused.value = total_weight ? (uint16_t)((weighted_sum + total_weight / 2) / total_weight) : median;
+    return true;
+}
+
+/**
+ * Fuse readings for many rooms with the same number of sensors each.
+ * Readings are a structure of arrays: values[sensor * rooms + room], so each sensor slot is a contiguous column.
+ * @param values: Readings, `sensors` columns of `rooms` values.
+ * @param health: Weights in the same layout as values.
+ * @param sensors: Sensors per room, at most CCS811_MAX_FUSED_SENSORS.
+ * @param rooms: Number of rooms.
+ * @param fused: One fused reading per room. Rooms without a healthy sensor get inliers = 0.
+ * @param config: Outlier rejection parameters.
+ * @return Number of rooms with a fused reading.
+ */
+size_t ccs811_fuse_batch(const uint16_t* values, const uint8_t* health, uint8_t sensors, size_t rooms,
+                         ccs811_fused_sample_t* fused, const ccs811_fusion_config_t& config) {
+    if (sensors > CCS811_MAX_FUSED_SENSORS) sensors = CCS811_MAX_FUSED_SENSORS;
+
+    size_t fused_rooms = 0;
+    uint16_t room_values[CCS811_MAX_FUSED_SENSORS];
+    uint8_t room_health[CCS811_MAX_FUSED_SENSORS];
+    for (size_t room = 0; room < rooms; room++) {
+        for (uint8_t sensor = 0; sensor < sensors; sensor++) {
+            room_values[sensor] = values[sensor * rooms + room];
+            room_health[sensor] = health[sensor * rooms + room];
+        }
+        if (ccs811_fuse(room_values, room_health, sensors, fused[room], config)) fused_rooms++;
+    }
+    return fused_rooms;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Create a resampler for one stream.
+ * @param grid_start_ms: Time of the first grid point.
+ * @param grid_period_ms: Spacing of the grid points.
+ * @param max_gap_ms: Longest time between samples that is still interpolated across.
+ */
+CCS811Resampler::CCS811Resampler(uint32_t grid_start_ms, uint32_t grid_period_ms, uint32_t max_gap_ms)
+    : _grid_period_ms(grid_period_ms ? grid_period_ms : 1),
+      _max_gap_ms(max_gap_ms),
+      _next_grid_ms(grid_start_ms),
+      _sample_count(0) {}
+
+/**
+ * Add the next sample of the stream. Grid points it completes can then be taken with next().
+ * Grid points completed by the previous sample must be taken first, since interpolating them needs that sample.
+ * @param sample: New sample, in time order.
+ * @return True if the sample was added; false if grid points are still pending or the sample is older than the last.
+ */
+bool CCS811Resampler::add(const ccs811_sample_t& sample) {
+    if (_sample_count > 0 and sample.time_ms < _current.time_ms) return false;
+    if (_sample_count == 2 and _next_grid_ms < _current.time_ms) return false;
+
+    _previous = _current;
+    _current = sample;
+    if (_sample_count < 2) _sample_count++;
+
+    // Grid points before the first sample cannot be interpolated; start at the first one after it
+    if (_sample_count == 1 and _next_grid_ms < sample.time_ms) {
+        uint32_t skipped = (sample.time_ms - _next_grid_ms + _grid_period_ms - 1) / _grid_period_ms;
+        _next_grid_ms += skipped * _grid_period_ms;
+    }
+    return true;
+}
+
+/**
+ * Take the next completed grid point.
+ * @param point: Container to write the grid point into.
+ * @return True if a grid point was available.
+ */
+bool CCS811Resampler::next(ccs811_grid_sample_t& point) {
+    if (_sample_count < 2 or _next_grid_ms >= _current.time_ms or _next_grid_ms < _previous.time_ms) return false;
+
+    point.time_ms = _next_grid_ms;
+    _next_grid_ms += _grid_period_ms;
+
+    uint32_t span = _current.time_ms - _previous.time_ms;
+    point.gap = span > _max_gap_ms;
+    if (point.gap) {
+        point.eCO2 = 0;
+        point.eTVOC = 0;
+        return true;
+    }
+
+    float fraction = (float)(point.time_ms - _previous.time_ms) / span;
+    point.eCO2 = (uint16_t)(_previous.eCO2 + ((float)_current.eCO2 - _previous.eCO2) * fraction + 0.5f);
+    point.eTVOC = (uint16_t)(_previous.eTVOC + ((float)_current.eTVOC - _previous.eTVOC) * fraction + 0.5f);
+    return true;
+}
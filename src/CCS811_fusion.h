@@ -0,0 +1,67 @@
+#ifndef CCS811_FUSION_H
+#define CCS811_FUSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "CCS811_driver.h"
+#include "CCS811_processing.h"
+
+const uint8_t CCS811_MAX_FUSED_SENSORS = 16;
+
+///////////////////////////////////////////////////////////////////////////////
+// FUSION
+
+typedef struct {
+    float outlier_threshold;  // Readings further than this many robust deviations from the median are rejected
+    float minimum_deviation;  // Floor for the robust deviation, so agreeing sensors do not reject small differences
+} ccs811_fusion_config_t;
+
+const ccs811_fusion_config_t CCS811_DEFAULT_FUSION_CONFIG = {3.0, 25.0};
+
+typedef struct {
+    uint16_t value;   // Health-weighted mean of the readings that were not rejected, or the median if none were
+    uint16_t median;  // Median of all healthy readings
+    uint8_t inliers;  // Number of readings used in the fused value
+} ccs811_fused_sample_t;
+
+uint8_t ccs811_sensor_health(ccs811_status_t status, ccs811_error_t error);
+bool ccs811_fuse(const uint16_t* values, const uint8_t* health, uint8_t count, ccs811_fused_sample_t& fused,
+                 const ccs811_fusion_config_t& config = CCS811_DEFAULT_FUSION_CONFIG);
+size_t ccs811_fuse_batch(const uint16_t* values, const uint8_t* health, uint8_t sensors, size_t rooms,
+                         ccs811_fused_sample_t* fused,
+                         const ccs811_fusion_config_t& config = CCS811_DEFAULT_FUSION_CONFIG);
+
+///////////////////////////////////////////////////////////////////////////////
+// TIME ALIGNMENT
+
+typedef struct {
+    uint32_t time_ms;  // Grid time
+    uint16_t eCO2;     // Interpolated eCO2, 0 if gap is set
+    uint16_t eTVOC;    // Interpolated eTVOC, 0 if gap is set
+    bool gap;          // True if the stream had no samples close enough to interpolate this grid point
+} ccs811_grid_sample_t;
+
+/**
+ * Maps one sensor's timestamped samples onto a common time grid by linear interpolation.
+ * Each grid point is produced once the first sample after it has arrived, so the lookahead is a single sample and the
+ * state is two samples per stream; take every completed grid point with next() before adding the following sample.
+ * Grid points in a gap between samples longer than the allowed gap are marked instead of interpolated. Streams
+ * resampled onto the same grid line up point for point for fusion or comparison.
+ */
+class CCS811Resampler {
+   public:
+    CCS811Resampler(uint32_t grid_start_ms, uint32_t grid_period_ms, uint32_t max_gap_ms);
+
+    bool add(const ccs811_sample_t& sample);
+    bool next(ccs811_grid_sample_t& point);
+
+   private:
+    uint32_t _grid_period_ms;
+    uint32_t _max_gap_ms;
+    uint32_t _next_grid_ms;
+    ccs811_sample_t _previous;
+    ccs811_sample_t _current;
+    uint8_t _sample_count;
+};
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef CCS811_HISTORY_H
+#define CCS811_HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __AVR__
+#include <util/atomic.h>
+#define CCS811_CACHE_LINE_SIZE 1
+#else
+#include <atomic>
+#define CCS811_CACHE_LINE_SIZE 64
+#endif
+
+/**
+ * Fixed-capacity ring of samples from one sensor, stored as separate columns.
+ * Queries over one field scan a contiguous array of that field only. Samples must be appended in time order; once full,
+ * the oldest sample is overwritten. Index 0 is always the oldest sample held.
+ *
+ * There is a single writer. A reader running concurrently with the writer (e.g. the writer in an ISR or another task)
+ * uses the sequence lock around each scan:
+ *
+ *     uint32_t sequence;
+ *     do {
+ *         sequence = history.read_begin();
+ *         ... read samples ...
+ *     } while (history.read_retry(sequence));
+ *
+ * The writer makes the sequence odd before it touches a slot and even again once the sample is complete, so a scan is
+ * only accepted if no write started or was in progress while it ran. On hosts the sequence uses acquire/release
+ * ordering and columns are accessed with relaxed atomic loads and stores, so torn scans are discarded rather than
+ * being undefined behaviour; on AVR, where a 32-bit access takes several instructions, the sequence is read and
+ * written with interrupts disabled. read_retry() never waits, so a reader in an ISR cannot deadlock on the writer.
+ */
+template <size_t CAPACITY>
+class CCS811History {
+   public:
+    void append(uint32_t time_ms, uint16_t eCO2, uint16_t eTVOC, uint8_t status) {
+        uint32_t sequence = begin_write();
+        size_t index = (sequence / 2 - load(_cleared_at)) % CAPACITY;
+        store(_time_ms[index], time_ms);
+        store(_eCO2[index], eCO2);
+        store(_eTVOC[index], eTVOC);
+        store(_status[index], status);
+        end_write(sequence + 2);
+    }
+
+    void clear() {
+        uint32_t sequence = begin_write();
+        store(_cleared_at, sequence / 2 + 1);
+        end_write(sequence + 2);
+    }
+
+    size_t size() const {
+        uint32_t count = write_count();
+        return count < CAPACITY ? count : CAPACITY;
+    }
+    size_t capacity() const { return CAPACITY; }
+
+    /**
+     * Number of samples appended since the last clear.
+     */
+    uint32_t get_write_count() const { return write_count(); }
+
+    /**
+     * Start a read section.
+     * @return Sequence to pass to read_retry() once the section's reads are done.
+     */
+    uint32_t read_begin() const { return load_sequence(); }
+
+    /**
+     * End a read section.
+     * @param sequence: Value returned by read_begin() at the start of the section.
+     * @return True if a write was in progress or completed during the section, so its reads must be discarded.
+     */
+    bool read_retry(uint32_t sequence) const {
+#ifndef __AVR__
+        std::atomic_thread_fence(std::memory_order_acquire);
+#endif
+        return (sequence & 1) or load_sequence() != sequence;
+    }
+
+    uint32_t time_ms(size_t i) const { return load(_time_ms[physical(i)]); }
+    uint16_t eCO2(size_t i) const { return load(_eCO2[physical(i)]); }
+    uint16_t eTVOC(size_t i) const { return load(_eTVOC[physical(i)]); }
+    uint8_t status(size_t i) const { return load(_status[physical(i)]); }
+
+    /**
+     * Find the samples taken in [start_ms, end_ms).
+     * @param start_ms: Start of the window (inclusive).
+     * @param end_ms: End of the window (exclusive).
+     * @param first: Set to the index of the first sample in the window.
+     * @return Number of samples in the window.
+     */
+    size_t window(uint32_t start_ms, uint32_t end_ms, size_t& first) const {
+        first = lower_bound(start_ms);
+        size_t last = lower_bound(end_ms);
+        return last > first ? last - first : 0;
+    }
+
+    /**
+     * Largest eCO2 or eTVOC reading in a range of samples.
+     * The range is split into at most two contiguous column scans where it wraps around the ring.
+     */
+    uint16_t max_eCO2(size_t first, size_t count) const { return column_max(_eCO2, first, count); }
+    uint16_t max_eTVOC(size_t first, size_t count) const { return column_max(_eTVOC, first, count); }
+
+   private:
+    alignas(CCS811_CACHE_LINE_SIZE) uint32_t _time_ms[CAPACITY];
+    alignas(CCS811_CACHE_LINE_SIZE) uint16_t _eCO2[CAPACITY];
+    alignas(CCS811_CACHE_LINE_SIZE) uint16_t _eTVOC[CAPACITY];
+    alignas(CCS811_CACHE_LINE_SIZE) uint8_t _status[CAPACITY];
+    uint32_t _cleared_at = 0;  // Completed writes, sequence / 2, once the last clear finished
+#ifdef __AVR__
+    volatile uint32_t _sequence = 0;
+#else
+    std::atomic<uint32_t> _sequence{0};
+#endif
+
+    template <typename T>
+    static T load(const T& value) {
+#ifdef __AVR__
+        return *(const volatile T*)&value;
+#else
+        return __atomic_load_n(&value, __ATOMIC_RELAXED);
+#endif
+    }
+
+    template <typename T>
+    static void store(T& target, T value) {
+#ifdef __AVR__
+        *(volatile T*)&target = value;
+#else
+        __atomic_store_n(&target, value, __ATOMIC_RELAXED);
+#endif
+    }
+
+    uint32_t load_sequence() const {
+#ifdef __AVR__
+        uint32_t sequence;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { sequence = _sequence; }
+        return sequence;
+#else
+        return _sequence.load(std::memory_order_acquire);
+#endif
+    }
+
+    // Make the sequence odd; the fence keeps the slot stores that follow from becoming visible before it
+    uint32_t begin_write() {
+#ifdef __AVR__
+        uint32_t sequence;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { sequence = _sequence++; }
+        return sequence;
+#else
+        uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return sequence;
+#endif
+    }
+
+    void end_write(uint32_t sequence) {
+#ifdef __AVR__
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { _sequence = sequence; }
+#else
+        _sequence.store(sequence, std::memory_order_release);
+#endif
+    }
+
+    uint32_t write_count() const { return load_sequence() / 2 - load(_cleared_at); }
+
+    size_t oldest() const {
+        uint32_t count = write_count();
+        return count < CAPACITY ? 0 : count % CAPACITY;
+    }
+    size_t physical(size_t i) const { return (oldest() + i) % CAPACITY; }
+
+    size_t lower_bound(uint32_t time_ms) const {
+        size_t low = 0;
+        size_t high = size();
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (load(_time_ms[physical(middle)]) < time_ms)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low;
+    }
+
+    uint16_t column_max(const uint16_t* column, size_t first, size_t count) const {
+        uint16_t result = 0;
+        size_t start = physical(first);
+        size_t run = count < CAPACITY - start ? count : CAPACITY - start;
+        for (size_t i = start; i < start + run; i++) {
+            uint16_t value = load(column[i]);
+            result = value > result ? value : result;
+        }
+        for (size_t i = 0; i < count - run; i++) {
+            uint16_t value = load(column[i]);
+            result = value > result ? value : result;
+        }
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,274 @@
+#include "CCS811_processing.h"
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Ohms per ADC count for each possible sensor current, i.e. 1.65V / 1023 / current.
+ * Index 0 (no current) maps to 0 so invalid samples produce a resistance of 0 without a branch.
+ */
+static const float RESISTANCE_PER_ADC_COUNT[64] PROGMEM = {
+    0, 1.612903e+03f, 8.064516e+02f, 5.376344e+02f,
+    4.032258e+02f, 3.225806e+02f, 2.688172e+02f, 2.304147e+02f,
+    2.016129e+02f, 1.792115e+02f, 1.612903e+02f, 1.466276e+02f,
+    1.344086e+02f, 1.240695e+02f, 1.152074e+02f, 1.075269e+02f,
+    1.008065e+02f, 9.487666e+01f, 8.960573e+01f, 8.488964e+01f,
+    8.064516e+01f, 7.680492e+01f, 7.331378e+01f, 7.012623e+01f,
+    6.720430e+01f, 6.451613e+01f, 6.203474e+01f, 5.973716e+01f,
+    5.760369e+01f, 5.561735e+01f, 5.376344e+01f, 5.202914e+01f,
+    5.040323e+01f, 4.887586e+01f, 4.743833e+01f, 4.608295e+01f,
+    4.480287e+01f, 4.359198e+01f, 4.244482e+01f, 4.135649e+01f,
+    4.032258e+01f, 3.933910e+01f, 3.840246e+01f, 3.750938e+01f,
+    3.665689e+01f, 3.584229e+01f, 3.506311e+01f, 3.431709e+01f,
+    3.360215e+01f, 3.291639e+01f, 3.225806e+01f, 3.162555e+01f,
+    3.101737e+01f, 3.043214e+01f, 2.986858e+01f, 2.932551e+01f,
+    2.880184e+01f, 2.829655e+01f, 2.780868e+01f, 2.733734e+01f,
+    2.688172e+01f, 2.644104e+01f, 2.601457e+01f, 2.560164e+01f,
+};
+
+/**
+ * Calculate the sensor resistance from a raw reading.
+ * @param data: Raw ADC and current reading, as returned by CCS811::read(ccs811_raw_data_t&).
+ * @return Sensor resistance in ohms, or 0 if no current was flowing.
+ */
+float ccs811_resistance(ccs811_raw_data_t data) {
+    return data.adc_reading * pgm_read_float(&RESISTANCE_PER_ADC_COUNT[data.current_uA]);
+}
+
+/**
+ * Calculate the sensor resistance for an array of raw readings.
+ * Uses a reciprocal lookup per current value instead of a divide per sample.
+ * @param data: Raw readings.
+ * @param resistances: Output array of at least `count` resistances in ohms (0 where no current was flowing).
+ * @param count: Number of readings to convert.
+ */
+void ccs811_resistances(const ccs811_raw_data_t* data, float* resistances, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        resistances[i] = data[i].adc_reading * pgm_read_float(&RESISTANCE_PER_ADC_COUNT[data[i].current_uA]);
+    }
+}
+
+/**
+ * Decode frames [first, count) one column at a time.
+ */
+static void decode_frames_scalar(const uint8_t* frames, size_t first, size_t count,
+                                 const ccs811_frame_columns_t& columns) {
+    if (columns.eCO2) {
+        for (size_t i = first; i < count; i++) {
+            const uint8_t* frame = frames + i * CCS811_FRAME_SIZE;
+            columns.eCO2[i] = (uint16_t)(frame[0] << 8 | frame[1]);
+        }
+    }
+    if (columns.eTVOC) {
+        for (size_t i = first; i < count; i++) {
+            const uint8_t* frame = frames + i * CCS811_FRAME_SIZE;
+            columns.eTVOC[i] = (uint16_t)(frame[2] << 8 | frame[3]);
+        }
+    }
+    if (columns.status) {
+        for (size_t i = first; i < count; i++) columns.status[i] = frames[i * CCS811_FRAME_SIZE + 4];
+    }
+    if (columns.error) {
+        for (size_t i = first; i < count; i++) columns.error[i] = frames[i * CCS811_FRAME_SIZE + 5];
+    }
+    if (columns.current_uA) {
+        for (size_t i = first; i < count; i++) columns.current_uA[i] = frames[i * CCS811_FRAME_SIZE + 6] >> 2;
+    }
+    if (columns.adc_reading) {
+        for (size_t i = first; i < count; i++) {
+            const uint8_t* frame = frames + i * CCS811_FRAME_SIZE;
+            columns.adc_reading[i] = (uint16_t)((frame[6] & 0x03) << 8 | frame[7]);
+        }
+    }
+}
+
+#if defined(__SSE2__)
+static inline __m128i byte_swap_16(__m128i words) {
+    return _mm_or_si128(_mm_slli_epi16(words, 8), _mm_srli_epi16(words, 8));
+}
+
+/**
+ * Decode frames eight at a time with SSE2, which every x86-64 target has.
+ * The eight frames are four 16-bit words each; a 4x8 word transpose puts each word position in its own register.
+ * @return Number of frames decoded, a multiple of 8.
+ */
+static size_t decode_frames_vector(const uint8_t* frames, size_t count, const ccs811_frame_columns_t& columns) {
+    const __m128i low_byte = _mm_set1_epi16(0x00FF);
+    const __m128i adc_mask = _mm_set1_epi16(0x03FF);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i* block = (const __m128i*)(frames + i * CCS811_FRAME_SIZE);
+        __m128i r0 = _mm_loadu_si128(block);
+        __m128i r1 = _mm_loadu_si128(block + 1);
+        __m128i r2 = _mm_loadu_si128(block + 2);
+        __m128i r3 = _mm_loadu_si128(block + 3);
+
+        __m128i t0 = _mm_unpacklo_epi16(r0, r1);
+        __m128i t1 = _mm_unpackhi_epi16(r0, r1);
+        __m128i t2 = _mm_unpacklo_epi16(r2, r3);
+        __m128i t3 = _mm_unpackhi_epi16(r2, r3);
+        __m128i u0 = _mm_unpacklo_epi16(t0, t1);
+        __m128i u1 = _mm_unpackhi_epi16(t0, t1);
+        __m128i u2 = _mm_unpacklo_epi16(t2, t3);
+        __m128i u3 = _mm_unpackhi_epi16(t2, t3);
+        __m128i eCO2 = _mm_unpacklo_epi64(u0, u2);          // Bytes 0-1 of each frame
+        __m128i eTVOC = _mm_unpackhi_epi64(u0, u2);         // Bytes 2-3
+        __m128i status_error = _mm_unpacklo_epi64(u1, u3);  // Bytes 4-5
+        __m128i raw = _mm_unpackhi_epi64(u1, u3);           // Bytes 6-7
+
+        if (columns.eCO2) _mm_storeu_si128((__m128i*)(columns.eCO2 + i), byte_swap_16(eCO2));
+        if (columns.eTVOC) _mm_storeu_si128((__m128i*)(columns.eTVOC + i), byte_swap_16(eTVOC));
+        if (columns.status) {
+            __m128i status = _mm_and_si128(status_error, low_byte);
+            _mm_storel_epi64((__m128i*)(columns.status + i), _mm_packus_epi16(status, status));
+        }
+        if (columns.error) {
+            __m128i error = _mm_srli_epi16(status_error, 8);
+            _mm_storel_epi64((__m128i*)(columns.error + i), _mm_packus_epi16(error, error));
+        }
+        if (columns.current_uA) {
+            __m128i current = _mm_srli_epi16(_mm_and_si128(raw, low_byte), 2);
+            _mm_storel_epi64((__m128i*)(columns.current_uA + i), _mm_packus_epi16(current, current));
+        }
+        if (columns.adc_reading) {
+            _mm_storeu_si128((__m128i*)(columns.adc_reading + i), _mm_and_si128(byte_swap_16(raw), adc_mask));
+        }
+    }
+    return i;
+}
+#elif defined(__ARM_NEON)
+static inline uint16x8_t byte_swap_16(uint16x8_t words) {
+    return vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(words)));
+}
+
+/**
+ * Decode frames eight at a time with NEON. vld4q_u16 de-interleaves the four 16-bit words of each frame.
+ * @return Number of frames decoded, a multiple of 8.
+ */
+static size_t decode_frames_vector(const uint8_t* frames, size_t count, const ccs811_frame_columns_t& columns) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint16x8x4_t words = vld4q_u16((const uint16_t*)(frames + i * CCS811_FRAME_SIZE));
+        if (columns.eCO2) vst1q_u16(columns.eCO2 + i, byte_swap_16(words.val[0]));
+        if (columns.eTVOC) vst1q_u16(columns.eTVOC + i, byte_swap_16(words.val[1]));
+        if (columns.status) vst1_u8(columns.status + i, vmovn_u16(words.val[2]));
+        if (columns.error) vst1_u8(columns.error + i, vshrn_n_u16(words.val[2], 8));
+        if (columns.current_uA) vst1_u8(columns.current_uA + i, vshr_n_u8(vmovn_u16(words.val[3]), 2));
+        if (columns.adc_reading) {
+            vst1q_u16(columns.adc_reading + i, vandq_u16(byte_swap_16(words.val[3]), vdupq_n_u16(0x03FF)));
+        }
+    }
+    return i;
+}
+#endif
+
+/**
+ * Decode a contiguous array of ALG_RESULT_DATA frames into separate columns.
+ * Frames are 8 bytes each, in the order transmitted by the sensor (eCO2, eTVOC, STATUS, ERROR_ID, RAW_DATA, all
+ * big-endian). On x86-64 (SSE2) and ARM with NEON, eight frames are decoded per step with explicit vector code; the
+ * remainder, and every frame on other targets such as AVR, are decoded by a scalar loop per column.
+ * @param frames: Start of the frame array.
+ * @param count: Number of frames to decode.
+ * @param columns: Destination columns.
+ */
+void ccs811_decode_frames(const uint8_t* frames, size_t count, const ccs811_frame_columns_t& columns) {
+    size_t decoded = 0;
+#if defined(__SSE2__) or defined(__ARM_NEON)
+    decoded = decode_frames_vector(frames, count, columns);
+#endif
+    decode_frames_scalar(frames, decoded, count, columns);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Create a raw data processor.
+ * @param model: Baseline tracking and conversion parameters.
+ */
+CCS811RawProcessor::CCS811RawProcessor(const ccs811_raw_model_t& model) : _model(model) { reset(); }
+
+/**
+ * Forget the baseline and all previous samples.
+ */
+void CCS811RawProcessor::reset() {
+    _baseline = 0;
+    _resistance = 0;
+    _eTVOC = 0;
+    _eCO2 = CCS811_MIN_eCO2;
+    _sample_count = 0;
+}
+
+/**
+ * Process a new raw sample.
+ * The baseline tracks the clean-air resistance: it follows rising resistance quickly and falling resistance slowly, so
+ * VOC events pull the resistance below the baseline.
+ * @param data: Raw reading from the sensor.
+ * @return True if the sample was valid and the estimates were updated.
+ */
+bool CCS811RawProcessor::update(ccs811_raw_data_t data) {
+    float resistance = ccs811_resistance(data);
+    if (resistance <= 0) return false;
+
+    _resistance = resistance;
+    if (_baseline <= 0) {
+        _baseline = resistance;
+    } else if (resistance > _baseline) {
+        _baseline += (resistance - _baseline) * _model.baseline_rise_rate;
+    } else {
+        _baseline += (resistance - _baseline) * _model.baseline_fall_rate;
+    }
+
+    float excess = _baseline / resistance - 1;
+    float eTVOC = excess > 0 ? _model.eTVOC_scale * powf(excess, _model.eTVOC_exponent) : 0;
+    if (eTVOC > CCS811_MAX_eTVOC) eTVOC = CCS811_MAX_eTVOC;
+
+    float eCO2 = CCS811_MIN_eCO2 + eTVOC * _model.eCO2_per_eTVOC;
+    if (eCO2 > CCS811_MAX_eCO2) eCO2 = CCS811_MAX_eCO2;
+
+    _eTVOC = (uint16_t)eTVOC;
+    _eCO2 = (uint16_t)eCO2;
+    _sample_count++;
+    return true;
+}
+
+/**
+ * Restore a previously saved clean-air baseline, e.g. after a power cycle.
+ * @param resistance: Baseline resistance in ohms.
+ */
+void CCS811RawProcessor::set_baseline(float resistance) { _baseline = resistance; }
+
+/**
+ * Get the current clean-air baseline.
+ * @return Baseline resistance in ohms, or 0 if no samples have been processed.
+ */
+float CCS811RawProcessor::get_baseline() { return _baseline; }
+
+/**
+ * Get the resistance of the latest valid sample.
+ * @return Sensor resistance in ohms.
+ */
+float CCS811RawProcessor::get_resistance() { return _resistance; }
+
+/**
+ * Get the latest equivalent total volatile organic compound estimate.
+ * @return eTVOC concentration in parts per billion.
+ */
+uint16_t CCS811RawProcessor::get_eTVOC() { return _eTVOC; }
+
+/**
+ * Get the latest equivalent CO2 estimate.
+ * @return eCO2 level in parts per million.
+ */
+uint16_t CCS811RawProcessor::get_eCO2() { return _eCO2; }
+
+/**
+ * Get the number of valid samples processed since the last reset.
+ * @return Sample count.
+ */
+uint32_t CCS811RawProcessor::get_sample_count() { return _sample_count; }
@@ -0,0 +1,101 @@
+#ifndef CCS811_PROCESSING_H
+#define CCS811_PROCESSING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "CCS811_driver.h"
+
+const float CCS811_ADC_REFERENCE_VOLTAGE = 1.65;
+const uint16_t CCS811_ADC_FULL_SCALE = 1023;
+
+const uint16_t CCS811_MIN_eCO2 = 400;    // Lowest eCO2 reported by the sensor algorithm (ppm)
+const uint16_t CCS811_MAX_eCO2 = 8192;   // Highest eCO2 reported by the sensor algorithm (ppm)
+const uint16_t CCS811_MAX_eTVOC = 1187;  // Highest eTVOC reported by the sensor algorithm (ppb)
+
+///////////////////////////////////////////////////////////////////////////////
+// SAMPLES
+
+typedef struct {
+    uint32_t time_ms;  // Time the sample was read, in milliseconds
+    uint16_t eCO2;     // Equivalent CO2 in parts per million
+    uint16_t eTVOC;    // Equivalent total volatile organic compounds in parts per billion
+} ccs811_sample_t;
+
+enum CCS811_FIELD {
+    CCS811_FIELD_eCO2 = 0,
+    CCS811_FIELD_eTVOC = 1,
+};
+
+inline uint16_t ccs811_sample_value(const ccs811_sample_t& sample, CCS811_FIELD field) {
+    return field == CCS811_FIELD_eCO2 ? sample.eCO2 : sample.eTVOC;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// RAW MODE PROCESSING
+
+/**
+ * Tuning of the host-side raw data algorithm.
+ * The conversion from resistance ratio to eTVOC is an empirical power law; the defaults are a starting point and should
+ * be fitted against ALG_RESULT_DATA from a sensor running in one of the algorithm drive modes.
+ */
+typedef struct {
+    float baseline_rise_rate;  // Fraction of the gap closed per sample when resistance is above the baseline
+    float baseline_fall_rate;  // Fraction of the gap closed per sample when resistance is below the baseline
+    float eTVOC_scale;         // eTVOC in ppb at a baseline/resistance ratio of 2
+    float eTVOC_exponent;      // Exponent applied to (baseline/resistance - 1)
+    float eCO2_per_eTVOC;      // eCO2 ppm added above the 400 ppm floor per ppb of eTVOC
+} ccs811_raw_model_t;
+
+const ccs811_raw_model_t CCS811_DEFAULT_RAW_MODEL = {0.05, 0.0001, 100.0, 1.5, 2.0};
+
+float ccs811_resistance(ccs811_raw_data_t data);
+void ccs811_resistances(const ccs811_raw_data_t* data, float* resistances, size_t count);
+
+/**
+ * Streaming processor for RAW_DATA samples, e.g. from CCS811_CONSTANT_POWER_250MS.
+ * Each update is constant time and the processor holds no buffers.
+ */
+class CCS811RawProcessor {
+   public:
+    CCS811RawProcessor(const ccs811_raw_model_t& model = CCS811_DEFAULT_RAW_MODEL);
+
+    bool update(ccs811_raw_data_t data);
+    void reset();
+
+    void set_baseline(float resistance);
+    float get_baseline();
+    float get_resistance();
+    uint16_t get_eTVOC();
+    uint16_t get_eCO2();
+    uint32_t get_sample_count();
+
+   private:
+    ccs811_raw_model_t _model;
+    float _baseline;
+    float _resistance;
+    uint16_t _eTVOC;
+    uint16_t _eCO2;
+    uint32_t _sample_count;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// BATCH DECODING
+
+const uint8_t CCS811_FRAME_SIZE = 8;  // Bytes in a full ALG_RESULT_DATA burst read
+
+/**
+ * Structure-of-arrays destination for decoded ALG_RESULT_DATA frames.
+ * Each non-null column must hold at least as many elements as frames decoded; null columns are skipped.
+ */
+typedef struct {
+    uint16_t* eCO2;         // Equivalent CO2 in parts per million
+    uint16_t* eTVOC;        // Equivalent total volatile organic compounds in parts per billion
+    uint8_t* status;        // Raw STATUS byte (see ccs811_status_t)
+    uint8_t* error;         // Raw ERROR_ID byte (see ccs811_error_t)
+    uint8_t* current_uA;    // Sensor current in uA
+    uint16_t* adc_reading;  // Raw 10-bit ADC reading
+} ccs811_frame_columns_t;
+
+void ccs811_decode_frames(const uint8_t* frames, size_t count, const ccs811_frame_columns_t& columns);
+
+#endif
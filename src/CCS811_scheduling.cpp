@@ -0,0 +1,223 @@
+#include "CCS811_scheduling.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Create a scheduler for one sensor.
+ * @param period_ms: Nominal sample period, e.g. ccs811_sample_period_ms() of the configured drive mode.
+ * @param margin_ms: How long after the predicted ready time to read.
+ * @param retry_ms: How long to wait before reading again after a read found no new sample.
+ */
+CCS811ReadScheduler::CCS811ReadScheduler(uint32_t period_ms, uint16_t margin_ms, uint16_t retry_ms)
+    : _period_ms(period_ms),
+      _margin_ms(margin_ms),
+      _retry_ms(retry_ms),
+      _ready_ms(0),
+      _last_read_ms(0),
+      _next_read_ms(0),
+      _has_ready(false),
+      _has_read(false),
+      _bracketed(false),
+      _lead_ms(0),
+      _probe_count(0) {
+    clear_stats();
+}
+
+/**
+ * Record the result of a read and schedule the next one.
+ * @param now_ms: Time the read completed.
+ * @param status: Status read in the same transaction as the data.
+ * @return True if the read returned a new sample.
+ */
+bool CCS811ReadScheduler::observe(uint32_t now_ms, ccs811_status_t status) {
+    _stats.reads++;
+
+    if (not status.data_ready) {
+        _stats.duplicate_reads++;
+        _last_read_ms = now_ms;
+        _has_read = true;
+        _bracketed = true;
+        _next_read_ms = now_ms + _retry_ms;
+        return false;
+    }
+
+    // The sample became ready after the previous read and no later than this one
+    uint32_t earliest_ms = _has_read ? _last_read_ms : now_ms - (uint32_t)_period_ms;
+    uint32_t ready_ms;
+    bool early = false;
+    if (_has_ready and _period_ms > 0) {
+        // Latest predicted ready time that is not after this read
+        uint32_t periods = (uint32_t)((now_ms - _ready_ms) / _period_ms);
+        if (periods == 0) periods = 1;
+
+        // More than one predicted sample since the previous read means the earlier ones were overwritten unread
+        uint32_t periods_before = (int32_t)(earliest_ms - _ready_ms) > 0
+                                      ? (uint32_t)((earliest_ms - _ready_ms) / _period_ms)
+                                      : 0;
+        if (periods > periods_before + 1) _stats.missed_samples += periods - periods_before - 1;
+
+        uint32_t predicted_ms = _ready_ms + (uint32_t)(periods * _period_ms);
+        early = not _bracketed and (int32_t)(predicted_ms - now_ms) >= 0;
+        ready_ms = predicted_ms;
+        if ((int32_t)(ready_ms - earliest_ms) < 0) ready_ms = earliest_ms;
+        if ((int32_t)(ready_ms - now_ms) > 0) ready_ms = now_ms;
+
+        float measured_ms = (float)(ready_ms - _ready_ms) / periods;
+        _period_ms += (measured_ms - _period_ms) / 8;
+    } else {
+        ready_ms = earliest_ms + (now_ms - earliest_ms) / 2;
+    }
+
+    uint32_t age_ms = now_ms - ready_ms;
+    _stats.total_age_ms += age_ms;
+    if (age_ms > _stats.max_age_ms) _stats.max_age_ms = age_ms;
+
+    _ready_ms = ready_ms;
+    _has_ready = true;
+    _last_read_ms = now_ms;
+    _has_read = true;
+    _bracketed = false;
+
+    uint32_t next_ready_ms = ready_ms + (uint32_t)_period_ms;
+    if (early) {
+        // The sample was ready before its prediction and no read has seen it not ready, so the edge is somewhere before
+        // this read. Lead the prediction twice as far each period until a read finds no new sample and brackets it.
+        uint32_t limit_ms = (uint32_t)_period_ms / 2;
+        _lead_ms = _lead_ms == 0 ? _margin_ms : (_lead_ms * 2u < limit_ms ? _lead_ms * 2u : limit_ms);
+        _probe_count = 0;
+        _next_read_ms = next_ready_ms - _lead_ms;
+    } else if (++_probe_count >= CCS811_SCHEDULER_PROBE_INTERVAL) {
+        _probe_count = 0;
+        _lead_ms = _margin_ms;
+        _next_read_ms = next_ready_ms - _lead_ms;
+    } else {
+        _lead_ms = 0;
+        _next_read_ms = next_ready_ms + _margin_ms;
+    }
+    return true;
+}
+
+/**
+ * Check if the next read is due.
+ * @param now_ms: Current time.
+ * @return True if the scheduled read time has been reached.
+ */
+bool CCS811ReadScheduler::is_due(uint32_t now_ms) { return (int32_t)(now_ms - _next_read_ms) >= 0; }
+
+/**
+ * Get the time the next read should happen.
+ * @return Scheduled read time in milliseconds.
+ */
+uint32_t CCS811ReadScheduler::get_next_read_ms() { return _next_read_ms; }
+
+/**
+ * Get the estimated time the latest sample became ready.
+ * @return Ready time in milliseconds.
+ */
+uint32_t CCS811ReadScheduler::get_ready_ms() { return _ready_ms; }
+
+/**
+ * Get the learned sample period.
+ * @return Sample period in milliseconds.
+ */
+float CCS811ReadScheduler::get_period_ms() { return _period_ms; }
+
+/**
+ * Get the read, duplicate and sample age counters accumulated since the last clear.
+ * @return Copy of the current statistics.
+ */
+ccs811_schedule_stats_t CCS811ReadScheduler::get_stats() { return _stats; }
+
+/**
+ * Reset all statistics to zero.
+ */
+void CCS811ReadScheduler::clear_stats() { _stats = {}; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Create a latency tracker for one sensor.
+ * @param slo_ms: Largest acceptable end-to-end latency from sample ready to consumer dequeue.
+ */
+CCS811LatencyTracker::CCS811LatencyTracker(uint32_t slo_ms) : _slo_ms(slo_ms) { clear(); }
+
+/**
+ * Reset all histograms and counters.
+ */
+void CCS811LatencyTracker::clear() {
+    _samples = 0;
+    _violations = 0;
+    for (uint8_t stage = 0; stage < CCS811_LATENCY_STAGES; stage++) {
+        for (uint8_t bucket = 0; bucket < CCS811_LATENCY_BUCKETS; bucket++) _counts[stage][bucket] = 0;
+    }
+}
+
+/**
+ * Record the latencies of a sample when the consumer takes it.
+ * @param timing: Timestamps collected as the sample moved through the pipeline.
+ * @param dequeue_ms: Time the consumer dequeued the sample.
+ */
+void CCS811LatencyTracker::record(const ccs811_sample_timing_t& timing, uint32_t dequeue_ms) {
+    uint32_t end_to_end_ms = dequeue_ms - timing.ready_ms;
+    add(CCS811_LATENCY_READ, timing.read_ms - timing.ready_ms);
+    add(CCS811_LATENCY_ENQUEUE, timing.enqueue_ms - timing.read_ms);
+    add(CCS811_LATENCY_DEQUEUE, dequeue_ms - timing.enqueue_ms);
+    add(CCS811_LATENCY_END_TO_END, end_to_end_ms);
+
+    _samples++;
+    if (end_to_end_ms > _slo_ms) _violations++;
+}
+
+/**
+ * Get the number of samples in one histogram bucket.
+ * @param stage: Pipeline stage.
+ * @param bucket: Bucket index, below CCS811_LATENCY_BUCKETS.
+ * @return Sample count, saturated at 4294967295.
+ */
+uint32_t CCS811LatencyTracker::get_count(CCS811_LATENCY_STAGE stage, uint8_t bucket) {
+    return bucket < CCS811_LATENCY_BUCKETS ? _counts[stage][bucket] : 0;
+}
+
+/**
+ * Estimate a latency quantile for a stage.
+ * @param stage: Pipeline stage.
+ * @param quantile: Quantile between 0 and 1, e.g. 0.99.
+ * @return Upper bound of the bucket containing the quantile in milliseconds (0 if nothing was recorded).
+ */
+uint32_t CCS811LatencyTracker::get_quantile_ms(CCS811_LATENCY_STAGE stage, float quantile) {
+    uint32_t total = 0;
+    for (uint8_t bucket = 0; bucket < CCS811_LATENCY_BUCKETS; bucket++) total += _counts[stage][bucket];
+    if (total == 0) return 0;
+
+    uint32_t rank = (uint32_t)(quantile * (total - 1));
+    uint32_t seen = 0;
+    for (uint8_t bucket = 0; bucket < CCS811_LATENCY_BUCKETS; bucket++) {
+        seen += _counts[stage][bucket];
+        if (seen > rank) return bucket == 0 ? 0 : (1UL << bucket) - 1;
+    }
+    return (1UL << (CCS811_LATENCY_BUCKETS - 1)) - 1;
+}
+
+/**
+ * Get the number of samples recorded.
+ * @return Sample count.
+ */
+uint32_t CCS811LatencyTracker::get_samples() { return _samples; }
+
+/**
+ * Get the number of samples whose end-to-end latency exceeded the objective.
+ * @return Violation count.
+ */
+uint32_t CCS811LatencyTracker::get_violations() { return _violations; }
+
+/**
+ * Add one latency to a stage histogram.
+ */
+void CCS811LatencyTracker::add(CCS811_LATENCY_STAGE stage, uint32_t latency_ms) {
+    uint8_t bucket = 0;
+    while (latency_ms and bucket < CCS811_LATENCY_BUCKETS - 1) {
+        latency_ms >>= 1;
+        bucket++;
+    }
+    if (_counts[stage][bucket] < 0xFFFFFFFF) _counts[stage][bucket]++;
+}
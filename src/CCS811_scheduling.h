@@ -0,0 +1,106 @@
+#ifndef CCS811_SCHEDULING_H
+#define CCS811_SCHEDULING_H
+
+#include <stdint.h>
+#include "CCS811_driver.h"
+
+const uint16_t CCS811_DEFAULT_READ_MARGIN_MS = 5;
+const uint16_t CCS811_DEFAULT_READ_RETRY_MS = 20;
+const uint8_t CCS811_SCHEDULER_PROBE_INTERVAL = 8;  // Every Nth read is scheduled early to detect phase drift
+
+///////////////////////////////////////////////////////////////////////////////
+// READ SCHEDULING
+
+typedef struct {
+    uint32_t reads;            // Reads observed
+    uint32_t duplicate_reads;  // Reads that found no new sample (data_ready clear)
+    uint32_t missed_samples;   // Samples that became ready but were overwritten before being read
+    uint32_t total_age_ms;     // Sum over new samples of the time between becoming ready and being read
+    uint32_t max_age_ms;       // Oldest sample age seen
+} ccs811_schedule_stats_t;
+
+/**
+ * Learns a sensor's sample period and phase from data_ready and schedules reads just after each sample is ready.
+ * Call observe() with the status of every read, and read again at get_next_read_ms(). Each ready sample's time is
+ * bracketed between the last read that was not ready and the read that was; the prediction from the learned period is
+ * pulled into that bracket, which locks the phase. Every few samples a read is scheduled slightly early so drift in
+ * either direction narrows the bracket. When an early read already finds the sample ready, the sensor runs fast: each
+ * following read leads the prediction twice as far until one finds no new sample and brackets the edge again.
+ */
+class CCS811ReadScheduler {
+   public:
+    CCS811ReadScheduler(uint32_t period_ms, uint16_t margin_ms = CCS811_DEFAULT_READ_MARGIN_MS,
+                        uint16_t retry_ms = CCS811_DEFAULT_READ_RETRY_MS);
+
+    bool observe(uint32_t now_ms, ccs811_status_t status);
+    bool is_due(uint32_t now_ms);
+    uint32_t get_next_read_ms();
+    uint32_t get_ready_ms();
+    float get_period_ms();
+    ccs811_schedule_stats_t get_stats();
+    void clear_stats();
+
+   private:
+    float _period_ms;
+    uint16_t _margin_ms;
+    uint16_t _retry_ms;
+    uint32_t _ready_ms;
+    uint32_t _last_read_ms;
+    uint32_t _next_read_ms;
+    bool _has_ready;
+    bool _has_read;
+    bool _bracketed;
+    uint32_t _lead_ms;
+    uint8_t _probe_count;
+    ccs811_schedule_stats_t _stats;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// LATENCY
+
+enum CCS811_LATENCY_STAGE {
+    CCS811_LATENCY_READ = 0,        // Sample ready to bus read complete
+    CCS811_LATENCY_ENQUEUE = 1,     // Bus read complete to enqueue for the consumer
+    CCS811_LATENCY_DEQUEUE = 2,     // Enqueue to consumer dequeue
+    CCS811_LATENCY_END_TO_END = 3,  // Sample ready to consumer dequeue
+};
+
+const uint8_t CCS811_LATENCY_STAGES = 4;
+const uint8_t CCS811_LATENCY_BUCKETS = 16;  // Bucket 0 is 0 ms, bucket i is [2^(i-1), 2^i) ms, the last is open-ended
+
+/**
+ * Timestamps of one sample as it moves through the acquisition pipeline, all from the same clock.
+ */
+typedef struct {
+    uint32_t ready_ms;    // Sample became ready: nINT edge time or CCS811ReadScheduler::get_ready_ms()
+    uint32_t read_ms;     // Bus read completed
+    uint32_t enqueue_ms;  // Sample handed to the consumer queue
+} ccs811_sample_timing_t;
+
+/**
+ * Per-sensor latency histograms for each pipeline stage, with a counter of samples whose end-to-end latency exceeded
+ * the service level objective. Histograms use power-of-two millisecond buckets with saturating 32-bit counts, so one
+ * tracker is 256 bytes of counts and holds years of 1 s samples.
+ */
+class CCS811LatencyTracker {
+   public:
+    CCS811LatencyTracker(uint32_t slo_ms);
+
+    void record(const ccs811_sample_timing_t& timing, uint32_t dequeue_ms);
+    void clear();
+
+    uint32_t get_count(CCS811_LATENCY_STAGE stage, uint8_t bucket);
+    uint32_t get_quantile_ms(CCS811_LATENCY_STAGE stage, float quantile);
+    uint32_t get_samples();
+    uint32_t get_violations();
+
+   private:
+    uint32_t _slo_ms;
+    uint32_t _samples;
+    uint32_t _violations;
+    uint32_t _counts[CCS811_LATENCY_STAGES][CCS811_LATENCY_BUCKETS];
+
+    void add(CCS811_LATENCY_STAGE stage, uint32_t latency_ms);
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "CCS811_statistics.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Create an empty aggregate.
+ */
+CCS811Aggregate::CCS811Aggregate() : _sketch(nullptr) { reset(); }
+
+/**
+ * Empty the aggregate, and its sketch if it has one.
+ */
+void CCS811Aggregate::reset() {
+    _count = 0;
+    _sum = 0;
+    _min = 0xFFFF;
+    _max = 0;
+    _time_above_ms = 0;
+    if (_sketch) _sketch->reset();
+}
+
+/**
+ * Track quantiles of the values added from now on.
+ * @param sketch: Sketch to add values to; must outlive the aggregate. nullptr to stop tracking quantiles.
+ */
+void CCS811Aggregate::set_sketch(CCS811AggregateSketch* sketch) { _sketch = sketch; }
+
+/**
+ * Add a value to the aggregate.
+ * @param value: Sample value.
+ * @param interval_ms: Time since the previous sample, counted as time above threshold if the value is above it.
+ * @param threshold: Threshold for time above threshold.
+ */
+void CCS811Aggregate::add(uint16_t value, uint32_t interval_ms, uint16_t threshold) {
+    _count++;
+    _sum += value;
+    if (value < _min) _min = value;
+    if (value > _max) _max = value;
+    if (value >= threshold) _time_above_ms += interval_ms;
+    if (_sketch) _sketch->add(value);
+}
+
+/**
+ * Combine another aggregate into this one.
+ * Quantiles stay exact only if both aggregates have a sketch; merging one without a sketch leaves this aggregate's
+ * quantiles covering its own values only.
+ * @param other: Aggregate over a disjoint set of samples.
+ */
+void CCS811Aggregate::merge(const CCS811Aggregate& other) {
+    _count += other._count;
+    _sum += other._sum;
+    if (other._min < _min) _min = other._min;
+    if (other._max > _max) _max = other._max;
+    _time_above_ms += other._time_above_ms;
+    if (_sketch and other._sketch) _sketch->merge(*other._sketch);
+}
+
+/**
+ * Get the number of values aggregated.
+ * @return Value count.
+ */
+uint32_t CCS811Aggregate::get_count() const { return _count; }
+
+/**
+ * Get the mean of the aggregated values.
+ * @return Mean, or 0 if the aggregate is empty.
+ */
+float CCS811Aggregate::get_mean() const { return _count ? (float)_sum / _count : 0; }
+
+/**
+ * Get the smallest aggregated value.
+ * @return Minimum, or 0xFFFF if the aggregate is empty.
+ */
+uint16_t CCS811Aggregate::get_min() const { return _min; }
+
+/**
+ * Get the largest aggregated value.
+ * @return Maximum, or 0 if the aggregate is empty.
+ */
+uint16_t CCS811Aggregate::get_max() const { return _max; }
+
+/**
+ * Get the total time the series spent at or above the threshold.
+ * @return Time in milliseconds.
+ */
+uint32_t CCS811Aggregate::get_time_above_ms() const { return _time_above_ms; }
+
+/**
+ * Estimate a quantile of the aggregated values.
+ * @param quantile: Quantile between 0 and 1, e.g. 0.95 for p95.
+ * @return Estimated value within the sketch's relative accuracy, or 0 if the aggregate is empty or has no sketch.
+ */
+uint16_t CCS811Aggregate::get_quantile(float quantile) const { return _sketch ? _sketch->get_quantile(quantile) : 0; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Aggregate the samples of a segment into time buckets.
+ * Blocks outside the query range are skipped from their headers without decoding. To spread a query over several
+ * cores, give each thread a reader over its own block-aligned slice of the segment and its own bucket array, then merge
+ * the bucket arrays element by element. The interval before the first sample of each slice, and of each block that
+ * follows a skipped one, is not counted towards time above threshold.
+ * @param reader: Reader positioned at the first block to aggregate.
+ * @param query: Time range, bucket width, series and threshold.
+ * @param buckets: Aggregates to add to, one per bucket.
+ * @param bucket_count: Number of buckets.
+ * @return Number of samples aggregated.
+ */
+uint32_t ccs811_aggregate_segment(CCS811SegmentReader& reader, const ccs811_aggregate_query_t& query,
+                                  CCS811Aggregate* buckets, size_t bucket_count) {
+    if (query.bucket_ms == 0 or bucket_count == 0) return 0;
+
+    // Cut the range off at the end of the clock rather than let it wrap; every sample before end_ms then has a bucket
+    uint32_t span_ms = 0xFFFFFFFF - query.start_ms;
+    uint32_t end_ms = 0xFFFFFFFF;
+    if (bucket_count <= span_ms / query.bucket_ms) end_ms = query.start_ms + query.bucket_ms * (uint32_t)bucket_count;
+    uint32_t aggregated = 0;
+    bool has_previous = false;
+    uint32_t previous_ms = 0;
+    size_t expected_offset = 0;
+
+    ccs811_block_header_t header;
+    while (reader.next_block(header, query.start_ms, end_ms)) {
+        if (reader.get_block_offset() != expected_offset) has_previous = false;
+        expected_offset = reader.get_block_offset() + CCS811_BLOCK_SIZE;
+
+        CCS811SampleDecoder decoder = reader.decode_block();
+        ccs811_sample_t sample;
+        while (decoder.next(sample)) {
+            uint32_t interval_ms = has_previous ? sample.time_ms - previous_ms : 0;
+            if (query.max_gap_ms and interval_ms > query.max_gap_ms) interval_ms = query.max_gap_ms;
+            has_previous = true;
+            previous_ms = sample.time_ms;
+            if (sample.time_ms < query.start_ms or sample.time_ms >= end_ms) continue;
+
+            uint16_t value = ccs811_sample_value(sample, query.field);
+            buckets[(sample.time_ms - query.start_ms) / query.bucket_ms].add(value, interval_ms, query.threshold);
+            aggregated++;
+        }
+    }
+    return aggregated;
+}
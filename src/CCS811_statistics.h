@@ -0,0 +1,238 @@
+#ifndef CCS811_STATISTICS_H
+#define CCS811_STATISTICS_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CCS811_processing.h"
+#include "CCS811_storage.h"
+
+template <uint16_t BUCKETS>
+class CCS811QuantileSketch;
+
+const uint16_t CCS811_AGGREGATE_SKETCH_BUCKETS = 128;  // About 3.6% relative accuracy, 520 bytes per sketch
+typedef CCS811QuantileSketch<CCS811_AGGREGATE_SKETCH_BUCKETS> CCS811AggregateSketch;
+
+///////////////////////////////////////////////////////////////////////////////
+// AGGREGATES
+
+/**
+ * Count, mean, min, max and time above a threshold for one series, and optionally its quantiles.
+ * Aggregates are mergeable: partial results computed over separate sets of blocks (e.g. on separate threads) combine
+ * with merge() into the result over all of them. Quantiles need a CCS811AggregateSketch per aggregate, attached with
+ * set_sketch(); they are opt-in so bucket arrays on small targets do not pay for them.
+ */
+class CCS811Aggregate {
+   public:
+    CCS811Aggregate();
+
+    void add(uint16_t value, uint32_t interval_ms, uint16_t threshold);
+    void merge(const CCS811Aggregate& other);
+    void reset();
+    void set_sketch(CCS811AggregateSketch* sketch);
+
+    uint32_t get_count() const;
+    float get_mean() const;
+    uint16_t get_min() const;
+    uint16_t get_max() const;
+    uint32_t get_time_above_ms() const;
+    uint16_t get_quantile(float quantile) const;
+
+   private:
+    uint32_t _count;
+    uint64_t _sum;
+    uint16_t _min;
+    uint16_t _max;
+    uint32_t _time_above_ms;
+    CCS811AggregateSketch* _sketch;
+};
+
+/**
+ * Grouped aggregation over stored samples: samples in [start_ms, start_ms + bucket_ms * bucket_count) are
+ * aggregated into fixed-width time buckets. A range that would end past the 32-bit clock is cut off at 0xFFFFFFFF.
+ * Each sample counts the time since the previous one towards time above threshold, up to max_gap_ms, so a sensor
+ * that was offline or not logging is not credited for the gap. Set it a little above the drive mode's sample period.
+ */
+typedef struct {
+    uint32_t start_ms;    // Start of the first bucket
+    uint32_t bucket_ms;   // Width of each bucket, e.g. 3600000 for hourly
+    CCS811_FIELD field;   // Series to aggregate
+    uint16_t threshold;   // Values at or above this count towards time above threshold
+    uint32_t max_gap_ms;  // Longest interval a sample is credited with; 0 for no limit
+} ccs811_aggregate_query_t;
+
+uint32_t ccs811_aggregate_segment(CCS811SegmentReader& reader, const ccs811_aggregate_query_t& query,
+                                  CCS811Aggregate* buckets, size_t bucket_count);
+
+///////////////////////////////////////////////////////////////////////////////
+// ROLLING WINDOWS
+
+/**
+ * Mean, min and max over the last SIZE values of a series, updated in amortised constant time per value.
+ * The sum is kept as a running total; min and max come from monotonic queues whose fronts are the current extremes.
+ * All memory is allocated at compile time: 6 bytes per value of window plus a few counters. For a time-based window,
+ * size it as window length / sample period of the drive mode, e.g. 15 for 15 minutes in CCS811_PULSED_60SEC.
+ */
+template <uint16_t SIZE>
+class CCS811RollingWindow {
+    static_assert(SIZE > 0, "Rolling window must hold at least one value");
+
+   public:
+    void add(uint16_t value) {
+        uint16_t position = _next;
+        if (_count == SIZE) {
+            _sum -= _values[position];
+            _max.expire(position);
+            _min.expire(position);
+        } else {
+            _count++;
+        }
+
+        _values[position] = value;
+        _sum += value;
+        _max.push(position, _values, true);
+        _min.push(position, _values, false);
+        _next = (position + 1) % SIZE;
+    }
+
+    void reset() {
+        _count = 0;
+        _next = 0;
+        _sum = 0;
+        _max.clear();
+        _min.clear();
+    }
+
+    uint16_t get_count() const { return _count; }
+    bool is_full() const { return _count == SIZE; }
+    float get_mean() const { return _count ? (float)_sum / _count : 0; }
+    uint16_t get_min() const { return _count ? _values[_min.front()] : 0; }
+    uint16_t get_max() const { return _count ? _values[_max.front()] : 0; }
+
+   private:
+    /**
+     * Queue of window positions whose values are monotonic (decreasing for max, increasing for min).
+     */
+    class MonotonicQueue {
+       public:
+        void clear() {
+            _head = 0;
+            _length = 0;
+        }
+
+        void push(uint16_t position, const uint16_t* values, bool keep_largest) {
+            while (_length > 0) {
+                uint16_t back = values[_positions[(_head + _length - 1) % SIZE]];
+                if (keep_largest ? back > values[position] : back < values[position]) break;
+                _length--;
+            }
+            _positions[(_head + _length) % SIZE] = position;
+            _length++;
+        }
+
+        void expire(uint16_t position) {
+            if (_length > 0 and _positions[_head] == position) {
+                _head = (_head + 1) % SIZE;
+                _length--;
+            }
+        }
+
+        uint16_t front() const { return _positions[_head]; }
+
+       private:
+        uint16_t _positions[SIZE];
+        uint16_t _head = 0;
+        uint16_t _length = 0;
+    };
+
+    uint16_t _values[SIZE];
+    uint16_t _count = 0;
+    uint16_t _next = 0;
+    uint32_t _sum = 0;
+    MonotonicQueue _max;
+    MonotonicQueue _min;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// QUANTILES
+
+/**
+ * Fixed-size quantile sketch for eCO2 or eTVOC values.
+ * Values are counted in BUCKETS logarithmically spaced buckets covering 0 to CCS811_MAX_eCO2, so memory is
+ * 4 * BUCKETS + 8 bytes regardless of how many values are added. Any quantile is returned within a relative error of
+ * get_relative_accuracy(): about 3.6% with 128 buckets (e.g. p95 of 1000 ppm reported as 964-1036 ppm), 7% with 64
+ * and 14% with 32. Sketches with the same BUCKETS merge exactly by adding counts, so per-sensor or per-day sketches
+ * can be combined into fleet or monthly ones. Each insert is one logarithm and one increment.
+ */
+template <uint16_t BUCKETS>
+class CCS811QuantileSketch {
+    static_assert(BUCKETS >= 3, "Quantile sketch needs at least 3 buckets");
+
+   public:
+    CCS811QuantileSketch() : _log_gamma(logf(CCS811_MAX_eCO2 + 1.0f) / (BUCKETS - 1)) { reset(); }
+
+    void add(uint16_t value) {
+        _counts[index(value)]++;
+        _count++;
+    }
+
+    void merge(const CCS811QuantileSketch& other) {
+        for (uint16_t i = 0; i < BUCKETS; i++) _counts[i] += other._counts[i];
+        _count += other._count;
+    }
+
+    void reset() {
+        for (uint16_t i = 0; i < BUCKETS; i++) _counts[i] = 0;
+        _count = 0;
+    }
+
+    uint32_t get_count() const { return _count; }
+
+    /**
+     * Estimate a quantile of the values added.
+     * @param quantile: Quantile between 0 and 1, e.g. 0.95 for p95.
+     * @return Estimated value, or 0 if the sketch is empty.
+     */
+    uint16_t get_quantile(float quantile) const {
+        if (_count == 0) return 0;
+        if (quantile < 0) quantile = 0;
+        if (quantile > 1) quantile = 1;
+
+        uint32_t rank = (uint32_t)(quantile * (_count - 1));
+        uint32_t seen = 0;
+        for (uint16_t i = 0; i < BUCKETS; i++) {
+            seen += _counts[i];
+            if (seen > rank) return value(i);
+        }
+        return value(BUCKETS - 1);
+    }
+
+    /**
+     * Worst-case relative error of get_quantile() for values within the sketch range.
+     */
+    float get_relative_accuracy() const {
+        float gamma = expf(_log_gamma);
+        return (gamma - 1) / (gamma + 1);
+    }
+
+   private:
+    float _log_gamma;
+    uint32_t _count;
+    uint32_t _counts[BUCKETS];
+
+    // Bucket 0 holds zero; bucket i > 0 holds [gamma^(i-1), gamma^i).
+    uint16_t index(uint16_t value) const {
+        if (value == 0) return 0;
+        uint16_t i = 1 + (uint16_t)(logf(value) / _log_gamma);
+        return i < BUCKETS ? i : BUCKETS - 1;
+    }
+
+    // Point with equal relative distance to both bucket bounds.
+    uint16_t value(uint16_t i) const {
+        if (i == 0) return 0;
+        float gamma = expf(_log_gamma);
+        return (uint16_t)(expf(_log_gamma * (i - 1)) * 2 * gamma / (1 + gamma) + 0.5f);
+    }
+};
+
+#endif
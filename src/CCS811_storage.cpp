@@ -0,0 +1,309 @@
+#include "CCS811_storage.h"
+#include <string.h>
+
+static bool header_is_valid(const ccs811_block_header_t& header) {
+    return header.magic == CCS811_BLOCK_MAGIC and header.payload_size <= CCS811_BLOCK_PAYLOAD_CAPACITY;
+}
+
+static bool checksum_is_valid(const uint8_t* block) {
+    uint32_t crc;
+    memcpy(&crc, block + CCS811_BLOCK_SIZE - CCS811_BLOCK_TRAILER_SIZE, sizeof(crc));
+    return crc == ccs811_crc32(block, CCS811_BLOCK_SIZE - CCS811_BLOCK_TRAILER_SIZE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Create a writer that fills the given block.
+ * @param block: Buffer of CCS811_BLOCK_SIZE bytes.
+ */
+CCS811BlockWriter::CCS811BlockWriter(uint8_t* block)
+    : _block(block),
+      _encoder(block + sizeof(ccs811_block_header_t), CCS811_BLOCK_PAYLOAD_CAPACITY, CCS811_BLOCK_KEYFRAME_INTERVAL) {
+    reset();
+}
+
+/**
+ * Empty the block so it can be reused for the next run of samples.
+ */
+void CCS811BlockWriter::reset() {
+    _encoder.reset();
+    memset(&_header, 0, sizeof(_header));
+    _header.magic = CCS811_BLOCK_MAGIC;
+    _header.min_eCO2 = 0xFFFF;
+    _header.min_eTVOC = 0xFFFF;
+}
+
+/**
+ * Add a sample to the block.
+ * Samples must be appended in time order.
+ * @param sample: Sample to add.
+ * @return True if the sample was added, false if the block is full and should be finished and stored.
+ */
+bool CCS811BlockWriter::append(const ccs811_sample_t& sample) {
+    if (not _encoder.append(sample)) return false;
+
+    if (_header.sample_count == 0) _header.start_time_ms = sample.time_ms;
+    _header.end_time_ms = sample.time_ms;
+    _header.sample_count++;
+    if (sample.eCO2 < _header.min_eCO2) _header.min_eCO2 = sample.eCO2;
+    if (sample.eCO2 > _header.max_eCO2) _header.max_eCO2 = sample.eCO2;
+    if (sample.eTVOC < _header.min_eTVOC) _header.min_eTVOC = sample.eTVOC;
+    if (sample.eTVOC > _header.max_eTVOC) _header.max_eTVOC = sample.eTVOC;
+    return true;
+}
+
+/**
+ * Write the header and checksum trailer, making the block ready to be stored.
+ * Unused payload bytes are zeroed so the stored block is deterministic.
+ */
+void CCS811BlockWriter::finish() {
+    _header.payload_size = _encoder.size();
+    memcpy(_block, &_header, sizeof(_header));
+
+    uint8_t* payload = _block + sizeof(_header);
+    memset(payload + _header.payload_size, 0, CCS811_BLOCK_PAYLOAD_CAPACITY - _header.payload_size);
+
+    uint32_t crc = ccs811_crc32(_block, CCS811_BLOCK_SIZE - CCS811_BLOCK_TRAILER_SIZE);
+    memcpy(_block + CCS811_BLOCK_SIZE - CCS811_BLOCK_TRAILER_SIZE, &crc, sizeof(crc));
+}
+
+/**
+ * Get the number of samples in the block.
+ * @return Sample count.
+ */
+uint16_t CCS811BlockWriter::get_sample_count() { return _header.sample_count; }
+
+/**
+ * Get the index header for the samples added so far.
+ * @return Block header.
+ */
+const ccs811_block_header_t& CCS811BlockWriter::get_header() { return _header; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Create a reader over a segment.
+ * @param segment: Start of the segment. Must stay valid while the reader is used.
+ * @param size: Size of the segment in bytes. A trailing partial block is ignored until extend() covers it.
+ */
+CCS811SegmentReader::CCS811SegmentReader(const uint8_t* segment, size_t size)
+    : _segment(segment), _size(size), _position(0), _block(nullptr) {}
+
+/**
+ * Advance to the next valid block.
+ * @param header: Container to read the block header into.
+ * @return True if a block was found, false at the end of the segment.
+ */
+bool CCS811SegmentReader::next_block(ccs811_block_header_t& header) { return find_block(header, false, 0, 0); }
+
+/**
+ * Advance to the next valid block that may hold samples in a time range.
+ * Blocks outside the range are skipped using their headers only, without checksumming them.
+ * @param header: Container to read the block header into.
+ * @param start_ms: Start of the range (inclusive).
+ * @param end_ms: End of the range (exclusive).
+ * @return True if a block was found, false at the end of the segment.
+ */
+bool CCS811SegmentReader::next_block(ccs811_block_header_t& header, uint32_t start_ms, uint32_t end_ms) {
+    return find_block(header, true, start_ms, end_ms);
+}
+
+/**
+ * Get a decoder over the samples of the current block.
+ * The decoder reads the segment in place; nothing is copied.
+ * @return Decoder for the block most recently returned by next_block(), or an empty decoder if there is none.
+ */
+CCS811SampleDecoder CCS811SegmentReader::decode_block() {
+    if (not _block) return CCS811SampleDecoder(nullptr, 0, CCS811_BLOCK_KEYFRAME_INTERVAL);
+
+    ccs811_block_header_t header;
+    memcpy(&header, _block, sizeof(header));
+    return CCS811SampleDecoder(_block + sizeof(header), header.payload_size, CCS811_BLOCK_KEYFRAME_INTERVAL);
+}
+
+/**
+ * Get the position of the current block, e.g. to tell whether blocks were skipped between two calls to next_block().
+ * @return Byte offset in the segment of the block most recently returned by next_block(), or the segment size if
+ * there is none.
+ */
+size_t CCS811SegmentReader::get_block_offset() { return _block ? _block - _segment : _size; }
+
+/**
+ * Make blocks appended since the reader was created visible.
+ * @param size: New size of the segment in bytes.
+ */
+void CCS811SegmentReader::extend(size_t size) {
+    if (size > _size) _size = size;
+}
+
+/**
+ * Follow a segment that was remapped to a new address, e.g. after its file grew. The position is kept.
+ * @param segment: Start of the new mapping, holding the same blocks at the same offsets.
+ * @param size: New size of the segment in bytes.
+ */
+void CCS811SegmentReader::extend(const uint8_t* segment, size_t size) {
+    if (_block) _block = segment + (_block - _segment);
+    _segment = segment;
+    extend(size);
+}
+
+/**
+ * Restart iteration at the first block of the segment.
+ */
+void CCS811SegmentReader::rewind() {
+    _position = 0;
+    _block = nullptr;
+}
+
+/**
+ * Advance to the next valid block, optionally skipping blocks outside a time range.
+ * The header is checked first, so blocks outside the range are skipped without checksumming them.
+ * @param header: Container to read the block header into.
+ * @param filter: True to skip blocks that do not overlap [start_ms, end_ms).
+ * @param start_ms: Start of the range (inclusive).
+ * @param end_ms: End of the range (exclusive).
+ * @return True if a block was found, false at the end of the segment.
+ */
+bool CCS811SegmentReader::find_block(ccs811_block_header_t& header, bool filter, uint32_t start_ms, uint32_t end_ms) {
+    _block = nullptr;
+    while (_position + CCS811_BLOCK_SIZE <= _size) {
+        const uint8_t* block = _segment + _position;
+        memcpy(&header, block, sizeof(header));
+        bool header_valid = header_is_valid(header);
+        if (header_valid and filter and not ccs811_block_overlaps(header, start_ms, end_ms)) {
+            _position += CCS811_BLOCK_SIZE;
+            continue;
+        }
+        if (header_valid and checksum_is_valid(block)) {
+            _position += CCS811_BLOCK_SIZE;
+            _block = block;
+            return true;
+        }
+        if (not skip_invalid_block()) return false;
+    }
+    return false;
+}
+
+/**
+ * Move past the invalid block at the current position, if a valid block follows it.
+ * An invalid block with nothing valid after it may be a write still in progress, so it is left to be read again.
+ * @return True if the position moved to the next valid block.
+ */
+bool CCS811SegmentReader::skip_invalid_block() {
+    for (size_t position = _position + CCS811_BLOCK_SIZE; position + CCS811_BLOCK_SIZE <= _size;
+         position += CCS811_BLOCK_SIZE) {
+        if (ccs811_block_is_valid(_segment + position)) {
+            _position = position;
+            return true;
+        }
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Check that a stored block is complete and uncorrupted.
+ * @param block: Buffer of CCS811_BLOCK_SIZE bytes.
+ * @return True if the magic number, payload size and checksum are all valid.
+ */
+bool ccs811_block_is_valid(const uint8_t* block) {
+    ccs811_block_header_t header;
+    memcpy(&header, block, sizeof(header));
+    return header_is_valid(header) and checksum_is_valid(block);
+}
+
+/**
+ * Check if a block may contain samples in a time range.
+ * @param header: Header of the block.
+ * @param start_ms: Start of the range (inclusive).
+ * @param end_ms: End of the range (exclusive).
+ * @return False if the block can be skipped.
+ */
+bool ccs811_block_overlaps(const ccs811_block_header_t& header, uint32_t start_ms, uint32_t end_ms) {
+    return header.sample_count > 0 and header.start_time_ms < end_ms and header.end_time_ms >= start_ms;
+}
+
+/**
+ * Check if a block may contain samples at or above a threshold.
+ * @param header: Header of the block.
+ * @param eCO2_threshold: eCO2 threshold in ppm.
+ * @param eTVOC_threshold: eTVOC threshold in ppb.
+ * @return False if every sample in the block is below both thresholds and the block can be skipped.
+ */
+bool ccs811_block_may_exceed(const ccs811_block_header_t& header, uint16_t eCO2_threshold, uint16_t eTVOC_threshold) {
+    return header.sample_count > 0 and (header.max_eCO2 >= eCO2_threshold or header.max_eTVOC >= eTVOC_threshold);
+}
+
+#ifndef __AVR__
+/**
+ * CRC-32 of each byte value, for the reflected polynomial 0xEDB88320.
+ */
+static const uint32_t CRC32_TABLE[256] = {
+    0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
+    0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
+    0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
+    0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+    0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9,
+    0xFA0F3D63, 0x8D080DF5, 0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
+    0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B, 0x35B5A8FA, 0x42B2986C,
+    0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+    0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423,
+    0xCFBA9599, 0xB8BDA50F, 0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
+    0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D, 0x76DC4190, 0x01DB7106,
+    0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+    0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D,
+    0x91646C97, 0xE6635C01, 0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
+    0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457, 0x65B0D9C6, 0x12B7E950,
+    0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+    0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7,
+    0xA4D1C46D, 0xD3D6F4FB, 0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
+    0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9, 0x5005713C, 0x270241AA,
+    0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+    0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81,
+    0xB7BD5C3B, 0xC0BA6CAD, 0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
+    0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683, 0xE3630B12, 0x94643B84,
+    0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+    0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB,
+    0x196C3671, 0x6E6B06E7, 0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
+    0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5, 0xD6D6A3E8, 0xA1D1937E,
+    0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+    0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55,
+    0x316E8EEF, 0x4669BE79, 0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
+    0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F, 0xC5BA3BBE, 0xB2BD0B28,
+    0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+    0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F,
+    0x72076785, 0x05005713, 0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
+    0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21, 0x86D3D2D4, 0xF1D4E242,
+    0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+    0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69,
+    0x616BFFD3, 0x166CCF45, 0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
+    0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB, 0xAED16A4A, 0xD9D65ADC,
+    0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+    0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693,
+    0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
+    0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D,
+};
+#endif
+
+/**
+ * Calculate the CRC-32 (IEEE 802.3) of a buffer.
+ * Computed bitwise on AVR to keep a 1 KB lookup table out of flash, and a byte at a time from the table elsewhere.
+ * @param data: Bytes to checksum.
+ * @param length: Number of bytes.
+ * @param crc: CRC of preceding data when checksumming in pieces, otherwise 0.
+ * @return CRC-32 of the data.
+ */
+uint32_t ccs811_crc32(const uint8_t* data, size_t length, uint32_t crc) {
+    crc = ~crc;
+#ifdef __AVR__
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+#else
+    for (size_t i = 0; i < length; i++) crc = (crc >> 8) ^ CRC32_TABLE[(crc ^ data[i]) & 0xFF];
+#endif
+    return ~crc;
+}
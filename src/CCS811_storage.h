@@ -0,0 +1,94 @@
+#ifndef CCS811_STORAGE_H
+#define CCS811_STORAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "CCS811_compression.h"
+#include "CCS811_processing.h"
+
+const uint16_t CCS811_BLOCK_SIZE = 512;  // Matches an SD card sector
+const uint16_t CCS811_BLOCK_MAGIC = 0xC811;
+const uint16_t CCS811_BLOCK_KEYFRAME_INTERVAL = 0xFFFF;  // Only the first sample of a block is a keyframe
+
+///////////////////////////////////////////////////////////////////////////////
+// BLOCKS
+
+/**
+ * Header at the start of every block. The time range and value extremes let queries skip blocks without decoding
+ * them.
+ */
+typedef struct {
+    uint32_t start_time_ms;  // Time of the first sample in the block
+    uint32_t end_time_ms;    // Time of the last sample in the block
+    uint16_t magic;          // CCS811_BLOCK_MAGIC
+    uint16_t sample_count;   // Number of samples encoded in the payload
+    uint16_t payload_size;   // Bytes of encoded samples following the header
+    uint16_t min_eCO2;
+    uint16_t max_eCO2;
+    uint16_t min_eTVOC;
+    uint16_t max_eTVOC;
+    uint16_t _reserved;
+} ccs811_block_header_t;
+
+const uint16_t CCS811_BLOCK_TRAILER_SIZE = 4;  // CRC-32 of header and payload
+const uint16_t CCS811_BLOCK_PAYLOAD_CAPACITY =
+    CCS811_BLOCK_SIZE - sizeof(ccs811_block_header_t) - CCS811_BLOCK_TRAILER_SIZE;
+
+/**
+ * Fills one fixed-size block with compressed samples.
+ * Blocks are meant to be appended to a segment (file, flash region) one whole block at a time. The CRC in the
+ * trailer is written last, so a block torn by a crash or power loss fails validation and is skipped by readers.
+ */
+class CCS811BlockWriter {
+   public:
+    CCS811BlockWriter(uint8_t* block);
+
+    bool append(const ccs811_sample_t& sample);
+    void finish();
+    void reset();
+
+    uint16_t get_sample_count();
+    const ccs811_block_header_t& get_header();
+
+   private:
+    uint8_t* _block;
+    CCS811SampleEncoder _encoder;
+    ccs811_block_header_t _header;
+};
+
+/**
+ * Iterates over the blocks of a segment held in memory, e.g. a memory-mapped segment file or a flash region.
+ * Blocks are validated and their headers read in place; samples are only decoded when a decoder is requested for a
+ * block. Corrupt blocks are skipped once a valid block follows them. An invalid block at the end of the segment may be
+ * a write in progress, so the reader stops there and returns the block once it is complete. Readers only see whole
+ * blocks, so a writer may keep appending while they run; extend() makes newly appended blocks visible, including
+ * when the segment has been remapped to a new address.
+ */
+class CCS811SegmentReader {
+   public:
+    CCS811SegmentReader(const uint8_t* segment, size_t size);
+
+    bool next_block(ccs811_block_header_t& header);
+    bool next_block(ccs811_block_header_t& header, uint32_t start_ms, uint32_t end_ms);
+    CCS811SampleDecoder decode_block();
+    size_t get_block_offset();
+    void extend(size_t size);
+    void extend(const uint8_t* segment, size_t size);
+    void rewind();
+
+   private:
+    const uint8_t* _segment;
+    size_t _size;
+    size_t _position;
+    const uint8_t* _block;
+
+    bool find_block(ccs811_block_header_t& header, bool filter, uint32_t start_ms, uint32_t end_ms);
+    bool skip_invalid_block();
+};
+
+bool ccs811_block_is_valid(const uint8_t* block);
+bool ccs811_block_overlaps(const ccs811_block_header_t& header, uint32_t start_ms, uint32_t end_ms);
+bool ccs811_block_may_exceed(const ccs811_block_header_t& header, uint16_t eCO2_threshold, uint16_t eTVOC_threshold);
+uint32_t ccs811_crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef CCS811_TEST_H
+#define CCS811_TEST_H
+
+/**
+ * Minimal self-registering test harness, so the host build needs nothing beyond a C++11 compiler.
+ * TEST(name) defines a test case; CHECK* macros record a failure and let the test continue.
+ */
+
+#include <stdint.h>
+
+typedef void (*test_fn_t)();
+
+typedef struct test_case {
+    const char* name;
+    test_fn_t function;
+    struct test_case* next;
+} test_case_t;
+
+void test_register(test_case_t* test);
+void test_fail(const char* file, int line, const char* message);
+void test_fail_equal(const char* file, int line, const char* expression, long long expected, long long actual);
+void test_fail_near(const char* file, int line, const char* expression, double expected, double actual);
+
+struct test_registrar {
+    test_case_t test;
+    test_registrar(const char* name, test_fn_t function) : test{name, function, nullptr} { test_register(&test); }
+};
+
+#define TEST(name)                                           \
+    static void name();                                      \
+    static test_registrar name##_registrar(#name, name);     \
+    static void name()
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (not(condition)) test_fail(__FILE__, __LINE__, "CHECK(" #condition ")"); \
+    } while (0)
+
+#define CHECK_EQUAL(expected, actual)                                                               \
+    do {                                                                                            \
+        long long expected_value = (long long)(expected);                                           \
+        long long actual_value = (long long)(actual);                                               \
+        if (expected_value != actual_value)                                                         \
+            test_fail_equal(__FILE__, __LINE__, #actual, expected_value, actual_value);             \
+    } while (0)
+
+#define CHECK_NEAR(expected, actual, tolerance)                                                     \
+    do {                                                                                            \
+        double expected_value = (double)(expected);                                                 \
+        double actual_value = (double)(actual);                                                     \
+        double difference = expected_value - actual_value;                                          \
+        if (difference > (tolerance) or difference < -(tolerance))                                  \
+            test_fail_near(__FILE__, __LINE__, #actual, expected_value, actual_value);              \
+    } while (0)
+
+#endif
@@ -0,0 +1,136 @@
+#include <string.h>
+#include "CCS811_compression.h"
+#include "test.h"
+
+static const uint32_t DAY_SAMPLES = 86400;
+static const size_t FIXED_RECORD_SIZE = 8;  // time, eCO2 and eTVOC as fixed-width fields
+
+/**
+ * A day of 1 s samples with a few ms of timestamp jitter and slowly drifting readings.
+ */
+static void make_day(ccs811_sample_t* samples, uint32_t count) {
+    uint32_t random = 1;
+    uint32_t time_ms = 5000;
+    int32_t eCO2 = 600;
+    for (uint32_t i = 0; i < count; i++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        time_ms += 997 + random % 7;
+        eCO2 += (int32_t)(random >> 8) % 5 - 2;
+        if (eCO2 < CCS811_MIN_eCO2) eCO2 = CCS811_MIN_eCO2;
+        samples[i].time_ms = time_ms;
+        samples[i].eCO2 = (uint16_t)eCO2;
+        samples[i].eTVOC = (uint16_t)((eCO2 - CCS811_MIN_eCO2) * 3 / 10 + (random >> 16) % 3);
+    }
+}
+
+static bool same_sample(const ccs811_sample_t& a, const ccs811_sample_t& b) {
+    return a.time_ms == b.time_ms and a.eCO2 == b.eCO2 and a.eTVOC == b.eTVOC;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(compression_round_trips_a_day_of_samples) {
+    static ccs811_sample_t samples[DAY_SAMPLES];
+    static uint8_t buffer[DAY_SAMPLES * CCS811_MAX_ENCODED_SAMPLE_SIZE];
+    make_day(samples, DAY_SAMPLES);
+
+    CCS811SampleEncoder encoder(buffer, sizeof(buffer));
+    for (uint32_t i = 0; i < DAY_SAMPLES; i++) CHECK(encoder.append(samples[i]));
+    CHECK_EQUAL(DAY_SAMPLES, encoder.get_sample_count());
+
+    CCS811SampleDecoder decoder(buffer, encoder.size());
+    ccs811_sample_t sample;
+    uint32_t matched = 0;
+    for (uint32_t i = 0; i < DAY_SAMPLES and decoder.next(sample); i++) matched += same_sample(samples[i], sample);
+    CHECK_EQUAL(DAY_SAMPLES, matched);
+    CHECK(not decoder.next(sample));
+
+    // About 3 bytes per steady-state sample against 8 for fixed records
+    double ratio = (double)DAY_SAMPLES * FIXED_RECORD_SIZE / encoder.size();
+    CHECK(ratio > 2.5);
+}
+
+TEST(compression_seeks_to_a_keyframe) {
+    ccs811_sample_t samples[200];
+    uint8_t buffer[sizeof(samples) / sizeof(samples[0]) * CCS811_MAX_ENCODED_SAMPLE_SIZE];
+    make_day(samples, 200);
+
+    CCS811SampleEncoder encoder(buffer, sizeof(buffer), 16);
+    size_t keyframe = 0;
+    for (uint32_t i = 0; i < 200; i++) {
+        encoder.append(samples[i]);
+        if (i == 160) keyframe = encoder.get_keyframe_offset();
+    }
+
+    CCS811SampleDecoder decoder(buffer, encoder.size(), 16);
+    decoder.seek(keyframe);
+    ccs811_sample_t sample;
+    uint32_t matched = 0;
+    for (uint32_t i = 160; i < 200 and decoder.next(sample); i++) matched += same_sample(samples[i], sample);
+    CHECK_EQUAL(40, matched);
+}
+
+TEST(compression_handles_extreme_steps) {
+    const ccs811_sample_t samples[] = {
+        {0xFFFFFF00, 0, 0}, {0xFFFFFFF0, 65535, 65535}, {0x00000010, 0, 0}, {0x00000010, 65535, 1}, {0x7FFFFFFF, 1, 2},
+    };
+    const size_t count = sizeof(samples) / sizeof(samples[0]);
+    uint8_t buffer[count * CCS811_MAX_ENCODED_SAMPLE_SIZE];
+
+    CCS811SampleEncoder encoder(buffer, sizeof(buffer));
+    for (size_t i = 0; i < count; i++) CHECK(encoder.append(samples[i]));
+
+    CCS811SampleDecoder decoder(buffer, encoder.size());
+    ccs811_sample_t sample;
+    for (size_t i = 0; i < count; i++) {
+        CHECK(decoder.next(sample));
+        CHECK(same_sample(samples[i], sample));
+    }
+}
+
+TEST(compression_stops_cleanly_when_the_buffer_is_full) {
+    ccs811_sample_t samples[50];
+    make_day(samples, 50);
+    uint8_t buffer[64];
+
+    CCS811SampleEncoder encoder(buffer, sizeof(buffer));
+    uint32_t appended = 0;
+    while (appended < 50 and encoder.append(samples[appended])) appended++;
+    CHECK(appended < 50);
+    CHECK(encoder.size() <= sizeof(buffer));
+
+    CCS811SampleDecoder decoder(buffer, encoder.size());
+    ccs811_sample_t sample;
+    uint32_t decoded = 0;
+    while (decoder.next(sample)) CHECK(same_sample(samples[decoded++], sample));
+    CHECK_EQUAL(appended, decoded);
+
+    // A stream cut in the middle of a sample is not decoded past the cut
+    CCS811SampleDecoder truncated(buffer, encoder.size() - 1);
+    decoded = 0;
+    while (truncated.next(sample)) decoded++;
+    CHECK_EQUAL(appended - 1, decoded);
+}
+
+TEST(compression_failed_decode_does_not_consume_the_sample) {
+    ccs811_sample_t samples[2];
+    make_day(samples, 2);
+    uint8_t buffer[32];
+    CCS811SampleEncoder encoder(buffer, sizeof(buffer));
+    CHECK(encoder.append(samples[0]));
+    size_t length = encoder.size();
+
+    // An overlong varint, then bytes that would decode as a sample if the decoder resumed inside it
+    const uint8_t corrupt[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x01, 0x01};
+    memcpy(buffer + length, corrupt, sizeof(corrupt));
+
+    CCS811SampleDecoder decoder(buffer, length + sizeof(corrupt));
+    ccs811_sample_t sample;
+    CHECK(decoder.next(sample));
+    CHECK(same_sample(samples[0], sample));
+    CHECK(not decoder.next(sample));
+    CHECK(not decoder.next(sample));
+    CHECK(same_sample(samples[0], sample));
+}
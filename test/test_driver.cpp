@@ -0,0 +1,235 @@
+#include <Arduino.h>
+#include <MockTwoWireDevice.h>
+#include "CCS811_driver.h"
+#include "test.h"
+
+static const uint8_t STATUS = 0x00;
+static const uint8_t ALG_RESULT_DATA = 0x02;
+static const uint8_t ENV_DATA = 0x05;
+static const uint8_t THRESHOLDS = 0x10;
+static const uint8_t HW_ID = 0x20;
+static const uint8_t APP_ERASE = 0xF1;
+static const uint8_t SW_RESET = 0xFF;
+
+/**
+ * A sensor on its own bus, backed by a register mock that answers the hardware ID check.
+ */
+struct driver_fixture {
+    TwoWire bus;
+    MockTwoWireDevice device;
+    CCS811 sensor;
+
+    driver_fixture() {
+        bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &device);
+        device.set_register(HW_ID, CCS811_HARDWARE_ID);
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(begin_checks_hardware_id) {
+    driver_fixture fixture;
+    CHECK(fixture.sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, fixture.bus));
+
+    fixture.device.set_register(HW_ID, 0x55);
+    CHECK(not fixture.sensor.comms_check());
+}
+
+TEST(begin_fails_without_device) {
+    TwoWire bus;
+    CCS811 sensor;
+    sensor.set_comms_retry_policy(0, 0);
+    CHECK(not sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus));
+    CHECK_EQUAL(CCS811_BUS_NACK, sensor.get_last_error());
+}
+
+TEST(comms_check_retries_on_virtual_time) {
+    driver_fixture fixture;
+    fixture.device.fail_next_transactions(3);
+    uint32_t start_ms = millis();
+
+    CHECK(fixture.sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, fixture.bus));
+    ccs811_bus_stats_t stats = fixture.sensor.get_bus_stats();
+    CHECK_EQUAL(3, stats.comms_retries);
+    CHECK_EQUAL(3 * CCS811_DEFAULT_COMMS_RETRY_DELAY_MS, stats.comms_retry_ms);
+    CHECK_EQUAL(3 * CCS811_DEFAULT_COMMS_RETRY_DELAY_MS, millis() - start_ms);
+}
+
+TEST(comms_check_gives_up_after_retry_budget) {
+    driver_fixture fixture;
+    fixture.sensor.set_comms_retry_policy(3, 10, true);
+    fixture.device.fail_next_transactions(100);
+
+    CHECK(not fixture.sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, fixture.bus));
+    ccs811_bus_stats_t stats = fixture.sensor.get_bus_stats();
+    CHECK_EQUAL(3, stats.comms_retries);
+    CHECK_EQUAL(10 + 20 + 40, stats.comms_retry_ms);
+    CHECK_EQUAL(4, stats.nacks);
+}
+
+TEST(comms_check_backoff_stops_doubling_at_the_maximum_delay) {
+    driver_fixture fixture;
+    fixture.sensor.set_comms_retry_policy(40, 1000, true);
+    fixture.device.fail_next_transactions(100);
+
+    CHECK(not fixture.sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, fixture.bus));
+    ccs811_bus_stats_t stats = fixture.sensor.get_bus_stats();
+    CHECK_EQUAL(40, stats.comms_retries);
+    CHECK_EQUAL(63000 + 34 * CCS811_MAX_COMMS_RETRY_DELAY_MS, stats.comms_retry_ms);
+}
+
+TEST(short_read_fails_by_default) {
+    driver_fixture fixture;
+    fixture.sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, fixture.bus);
+    fixture.device.shorten_next_reads(1, 3);
+
+    ccs811_all_data_t data;
+    CHECK(not fixture.sensor.read(data));
+    CHECK_EQUAL(CCS811_BUS_SHORT_READ, fixture.sensor.get_last_error());
+    CHECK_EQUAL(1, fixture.sensor.get_bus_stats().short_reads);
+    CHECK_EQUAL(0, fixture.sensor.get_bus_stats().short_read_retries);
+}
+
+TEST(short_read_is_retried_within_budget) {
+    driver_fixture fixture;
+    fixture.sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, fixture.bus);
+    fixture.sensor.set_short_read_retries(2);
+    fixture.device.shorten_next_reads(2, 1);
+
+    ccs811_all_data_t data;
+    CHECK(fixture.sensor.read(data));
+    CHECK_EQUAL(CCS811_BUS_OK, fixture.sensor.get_last_error());
+    CHECK_EQUAL(2, fixture.sensor.get_bus_stats().short_read_retries);
+}
+
+TEST(air_quality_decodes_big_endian_registers) {
+    driver_fixture fixture;
+    fixture.sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, fixture.bus);
+    const uint8_t frame[] = {0x01, 0x90, 0x00, 0x2A};  // eCO2 400 ppm, eTVOC 42 ppb
+    fixture.device.set_register(ALG_RESULT_DATA, frame, sizeof(frame));
+
+    CHECK_EQUAL(400, fixture.sensor.get_eCO2());
+    CHECK_EQUAL(42, fixture.sensor.get_eTVOC());
+
+    ccs811_air_quality_data_t data;
+    CHECK(fixture.sensor.read(data));
+    CHECK_EQUAL(400, data.eCO2_reading.total);
+    CHECK_EQUAL(42, data.eTVOC_reading.total);
+}
+
+TEST(all_data_decodes_every_field) {
+    driver_fixture fixture;
+    fixture.sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, fixture.bus);
+    // eCO2 1234, eTVOC 56, STATUS app mode + data ready, ERROR_ID heater current, RAW 20 uA / ADC 500
+    const uint8_t frame[] = {0x04, 0xD2, 0x00, 0x38, 0x98, 0x10, 0x51, 0xF4};
+    fixture.device.set_register(ALG_RESULT_DATA, frame, sizeof(frame));
+
+    ccs811_all_data_t data;
+    CHECK(fixture.sensor.read(data));
+    CHECK_EQUAL(1234, data.eCO2_ppb_reading.total);
+    CHECK_EQUAL(56, data.eTVOC_ppm_reading.total);
+    CHECK(data.status.data_ready);
+    CHECK(data.status.firmware_is_in_application_mode);
+    CHECK(data.error.heater_current_not_in_range);
+    CHECK_EQUAL(20, data.raw_data.current_uA);
+    CHECK_EQUAL(500, data.raw_data.adc_reading);
+}
+
+TEST(bus_stats_count_transfers_and_bytes) {
+    driver_fixture fixture;
+    fixture.sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, fixture.bus);
+    fixture.sensor.clear_bus_stats();
+
+    ccs811_status_t status;
+    fixture.sensor.read(status);
+    fixture.sensor.write_environmental_data(25.0, 50.0);
+
+    ccs811_bus_stats_t stats = fixture.sensor.get_bus_stats();
+    CHECK_EQUAL(3, stats.transfers);
+    CHECK_EQUAL(1 + 5, stats.bytes_written);
+    CHECK_EQUAL(1, stats.bytes_read);
+    // 3 transfers * 11 bits + 7 bytes * 9 bits at 100 kHz
+    CHECK_EQUAL(960, ccs811_bus_time_us(stats, 100000));
+    CHECK_EQUAL(0, ccs811_bus_time_us(stats, 0));
+}
+
+TEST(writes_use_register_byte_order) {
+    driver_fixture fixture;
+    fixture.sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, fixture.bus);
+
+    fixture.sensor.write_environmental_data(25.0, 50.0);
+    const uint8_t environment[] = {ENV_DATA, 0x64, 0x00, 0x00, 0x00};
+    CHECK_EQUAL(sizeof(environment), fixture.device.get_last_write_length());
+    CHECK(memcmp(environment, fixture.device.get_last_write(), sizeof(environment)) == 0);
+
+    fixture.sensor.write_co2_thresholds(1500, 2500);
+    const uint8_t thresholds[] = {THRESHOLDS, 0x05, 0xDC, 0x09, 0xC4};
+    CHECK(memcmp(thresholds, fixture.device.get_last_write(), sizeof(thresholds)) == 0);
+
+    ccs811_co2_thresholds_t read_back;
+    CHECK(fixture.sensor.read(read_back));
+    CHECK_EQUAL(1500, read_back.low_limit);
+    CHECK_EQUAL(2500, read_back.high_limit);
+}
+
+TEST(command_sequences_are_written_whole) {
+    driver_fixture fixture;
+    fixture.sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, fixture.bus);
+
+    CHECK(fixture.sensor.start_application_erase());
+    const uint8_t erase[] = {APP_ERASE, 0xE7, 0xA7, 0xE6, 0x09};
+    CHECK_EQUAL(sizeof(erase), fixture.device.get_last_write_length());
+    CHECK(memcmp(erase, fixture.device.get_last_write(), sizeof(erase)) == 0);
+
+    CHECK(fixture.sensor.reset());
+    const uint8_t reset[] = {SW_RESET, 0x11, 0xE5, 0x72, 0x8A};
+    CHECK_EQUAL(sizeof(reset), fixture.device.get_last_write_length());
+    CHECK(memcmp(reset, fixture.device.get_last_write(), sizeof(reset)) == 0);
+}
+
+TEST(read_new_reports_each_sample_once) {
+    driver_fixture fixture;
+    fixture.sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, fixture.bus);
+    ccs811_air_quality_data_t data;
+    data.eCO2_reading.total = 0;
+
+    const uint8_t stale[] = {0x01, 0x90, 0x00, 0x2A, 0x90};
+    fixture.device.set_register(ALG_RESULT_DATA, stale, sizeof(stale));
+    CHECK_EQUAL(CCS811_READ_NO_NEW_DATA, fixture.sensor.read_new(data));
+    CHECK_EQUAL(0, data.eCO2_reading.total);
+    CHECK_EQUAL(0, fixture.sensor.get_sample_sequence());
+
+    const uint8_t fresh[] = {0x01, 0x90, 0x00, 0x2A, 0x98};
+    fixture.device.set_register(ALG_RESULT_DATA, fresh, sizeof(fresh));
+    CHECK_EQUAL(CCS811_READ_NEW_DATA, fixture.sensor.read_new(data));
+    CHECK_EQUAL(400, data.eCO2_reading.total);
+    CHECK_EQUAL(42, data.eTVOC_reading.total);
+    CHECK_EQUAL(1, fixture.sensor.get_sample_sequence());
+
+    fixture.device.fail_next_transactions(1);
+    CHECK_EQUAL(CCS811_READ_ERROR, fixture.sensor.read_new(data));
+    CHECK_EQUAL(CCS811_BUS_NACK, fixture.sensor.get_last_error());
+}
+
+TEST(injected_clock_replaces_millis) {
+    static uint32_t now_ms = 5000;
+    struct clock {
+        static uint32_t now() { return now_ms; }
+        static void wait(uint32_t ms) { now_ms += ms; }
+    };
+
+    driver_fixture fixture;
+    fixture.sensor.set_clock(clock::now, clock::wait);
+    CHECK_EQUAL(5000, fixture.sensor.get_time_ms());
+    fixture.sensor.delay_ms(250);
+    CHECK_EQUAL(5250, fixture.sensor.get_time_ms());
+}
+
+TEST(sample_period_per_drive_mode) {
+    CHECK_EQUAL(0, ccs811_sample_period_ms(CCS811_IDLE_MODE));
+    CHECK_EQUAL(1000, ccs811_sample_period_ms(CCS811_CONSTANT_POWER_1SEC));
+    CHECK_EQUAL(10000, ccs811_sample_period_ms(CCS811_PULSED_10SEC));
+    CHECK_EQUAL(60000, ccs811_sample_period_ms(CCS811_PULSED_60SEC));
+    CHECK_EQUAL(250, ccs811_sample_period_ms(CCS811_CONSTANT_POWER_250MS));
+    CHECK_EQUAL(0, ccs811_sample_period_ms(7));
+}
@@ -0,0 +1,229 @@
+#include <stdlib.h>
+#include "CCS811_filters.h"
+#include "test.h"
+
+static const uint32_t STEP_SAMPLES = 2000;
+
+/**
+ * A step from 400 to 800 ppm halfway through, with roughly Gaussian noise of about 40 ppm standard deviation.
+ */
+static void make_noisy_step(uint16_t* truth, uint16_t* noisy, uint32_t count) {
+    srand(3);
+    for (uint32_t i = 0; i < count; i++) {
+        truth[i] = i < count / 2 ? 400 : 800;
+        int32_t noise = 0;
+        for (uint8_t j = 0; j < 12; j++) noise += rand() % 2001 - 1000;
+        noisy[i] = (uint16_t)(truth[i] + noise / 50);
+    }
+}
+
+/**
+ * Mean absolute error, skipping the settling time after the start and after the step.
+ */
+static double settled_error(const uint16_t* truth, const uint16_t* values, uint32_t count, uint32_t settle) {
+    double error = 0;
+    uint32_t counted = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (i % (count / 2) < settle) continue;
+        error += abs((int32_t)values[i] - (int32_t)truth[i]);
+        counted++;
+    }
+    return error / counted;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SMOOTHING
+
+TEST(filters_start_from_the_first_sample) {
+    ccs811_iir_state_t iir = CCS811_IIR_INITIAL_STATE;
+    CHECK_EQUAL(612, ccs811_iir_update(iir, 612, 16));
+    CHECK_EQUAL(612, ccs811_iir_update(iir, 612, 16));
+    CHECK_EQUAL(614, ccs811_iir_update(iir, 644, 16));
+
+    ccs811_kalman_state_t kalman = CCS811_KALMAN_INITIAL_STATE;
+    ccs811_kalman_config_t config = {4, 400};
+    CHECK_EQUAL(612, ccs811_kalman_update(kalman, config, 612));
+    CHECK_EQUAL(400, kalman.variance);
+}
+
+TEST(filters_clamp_out_of_range_inputs) {
+    // Full-scale readings and weights used to overflow the 32-bit fixed-point products
+    ccs811_iir_state_t iir = CCS811_IIR_INITIAL_STATE;
+    CHECK_EQUAL(0, ccs811_iir_update(iir, 0, 0xFFFF));
+    CHECK_EQUAL(CCS811_MAX_eCO2, ccs811_iir_update(iir, 0xFFFF, 0xFFFF));
+    CHECK_EQUAL(0, ccs811_iir_update(iir, 0, 0xFFFF));
+
+    ccs811_kalman_state_t kalman = CCS811_KALMAN_INITIAL_STATE;
+    ccs811_kalman_config_t config = {CCS811_MAX_VARIANCE, 1};
+    CHECK_EQUAL(0, ccs811_kalman_update(kalman, config, 0));
+    uint16_t value = ccs811_kalman_update(kalman, config, 0xFFFF);
+    // A gain of 255/256 moves the estimate all but 1/256 of the way
+    CHECK(value >= CCS811_MAX_eCO2 / 256 * 255 and value <= CCS811_MAX_eCO2);
+    CHECK(ccs811_kalman_update(kalman, config, 0) <= CCS811_MAX_eCO2 / 256);
+}
+
+TEST(filters_reduce_noise_and_follow_a_step) {
+    static uint16_t truth[2 * STEP_SAMPLES], noisy[2 * STEP_SAMPLES];
+    static uint16_t iir[2 * STEP_SAMPLES], kalman[2 * STEP_SAMPLES];
+    make_noisy_step(truth, noisy, 2 * STEP_SAMPLES);
+
+    ccs811_iir_state_t iir_state = CCS811_IIR_INITIAL_STATE;
+    ccs811_kalman_state_t kalman_state = CCS811_KALMAN_INITIAL_STATE;
+    ccs811_kalman_config_t config = {4, 1600};
+    for (uint32_t i = 0; i < 2 * STEP_SAMPLES; i++) {
+        iir[i] = ccs811_iir_update(iir_state, noisy[i], 16);
+        kalman[i] = ccs811_kalman_update(kalman_state, config, noisy[i]);
+    }
+
+    double raw_error = settled_error(truth, noisy, 2 * STEP_SAMPLES, 200);
+    // Both cut the error about 5-6x
+    CHECK(raw_error > 25);
+    CHECK(raw_error / settled_error(truth, iir, 2 * STEP_SAMPLES, 200) > 5);
+    CHECK(raw_error / settled_error(truth, kalman, 2 * STEP_SAMPLES, 200) > 5);
+    CHECK_NEAR(800, iir[2 * STEP_SAMPLES - 1], 15);
+    CHECK_NEAR(800, kalman[2 * STEP_SAMPLES - 1], 15);
+}
+
+TEST(filter_batches_match_single_updates) {
+    const size_t sensors = 37;
+    int32_t values[sensors], estimates[sensors];
+    uint32_t variances[sensors];
+    uint16_t samples[sensors], iir_outputs[sensors], kalman_outputs[sensors];
+    ccs811_iir_state_t iir[sensors];
+    ccs811_kalman_state_t kalman[sensors];
+    ccs811_kalman_config_t config = {16, 900};
+    for (size_t s = 0; s < sensors; s++) {
+        values[s] = estimates[s] = CCS811_FILTER_EMPTY;
+        variances[s] = 0;
+        iir[s] = CCS811_IIR_INITIAL_STATE;
+        kalman[s] = CCS811_KALMAN_INITIAL_STATE;
+    }
+
+    uint32_t mismatches = 0;
+    srand(5);
+    for (uint32_t step = 0; step < 500; step++) {
+        for (size_t s = 0; s < sensors; s++) samples[s] = (uint16_t)(400 + s * 20 + rand() % 100);
+        ccs811_iir_update_batch(values, samples, iir_outputs, sensors, 32);
+        ccs811_kalman_update_batch(estimates, variances, samples, kalman_outputs, sensors, config);
+        for (size_t s = 0; s < sensors; s++) {
+            mismatches += iir_outputs[s] != ccs811_iir_update(iir[s], samples[s], 32);
+            mismatches += kalman_outputs[s] != ccs811_kalman_update(kalman[s], config, samples[s]);
+        }
+    }
+    CHECK_EQUAL(0, mismatches);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ANOMALY DETECTION
+
+TEST(anomaly_detector_flags_spikes_and_steps) {
+    CCS811AnomalyDetector detector;
+    for (uint16_t i = 0; i < 100; i++) detector.update(100 + i % 5);
+    CHECK_EQUAL(CCS811_ANOMALY_NONE, detector.get_anomalies());
+
+    CHECK(detector.update(400));
+    CHECK_EQUAL(CCS811_ANOMALY_SPIKE | CCS811_ANOMALY_RATE, detector.get_anomalies());
+    CHECK(detector.update(102));
+    CHECK_EQUAL(CCS811_ANOMALY_RATE, detector.get_anomalies());
+    CHECK(detector.update(103));
+    CHECK_EQUAL(CCS811_ANOMALY_NONE, detector.get_anomalies());
+}
+
+TEST(anomaly_detector_flags_stuck_after_stuck_samples_repeats) {
+    ccs811_anomaly_config_t config = CCS811_DEFAULT_eTVOC_ANOMALY_CONFIG;
+    config.stuck_samples = 3;
+    CCS811AnomalyDetector detector(config);
+    for (uint8_t i = 0; i < 3; i++) {
+        CHECK(not detector.update(120));
+        CHECK_EQUAL(CCS811_ANOMALY_NONE, detector.get_anomalies());
+    }
+    CHECK(detector.update(120));
+    CHECK_EQUAL(CCS811_ANOMALY_STUCK, detector.get_anomalies());
+    CHECK(detector.update(121));
+    CHECK_EQUAL(CCS811_ANOMALY_NONE, detector.get_anomalies());
+}
+
+TEST(anomaly_detector_stays_stuck_past_the_counter_range) {
+    CCS811AnomalyDetector detector;
+    uint32_t changes = 0;
+    for (uint32_t i = 0; i < 200000; i++) changes += detector.update(120);
+    CHECK_EQUAL(1, changes);
+    CHECK_EQUAL(CCS811_ANOMALY_STUCK, detector.get_anomalies());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// DOWNSAMPLING
+
+static const uint32_t SERIES_SAMPLES = 10000;
+
+/**
+ * A gently varying eCO2 series at 1 s with a one-sample peak and dip that plain decimation by 100 would miss.
+ */
+static void make_peaked_series(ccs811_sample_t* series) {
+    for (uint32_t i = 0; i < SERIES_SAMPLES; i++) {
+        series[i] = {1000 * i, (uint16_t)(500 + i % 200 / 4), (uint16_t)(i % 10)};
+    }
+    series[4321].eCO2 = 2500;
+    series[7777].eCO2 = 420;
+}
+
+static bool contains(const ccs811_sample_t* samples, size_t count, uint32_t time_ms) {
+    for (size_t i = 0; i < count; i++) {
+        if (samples[i].time_ms == time_ms) return true;
+    }
+    return false;
+}
+
+TEST(downsample_keeps_peaks_and_ends) {
+    static ccs811_sample_t series[SERIES_SAMPLES];
+    make_peaked_series(series);
+    ccs811_sample_t output[100];
+    CHECK_EQUAL(100, ccs811_downsample(series, SERIES_SAMPLES, output, 100, CCS811_FIELD_eCO2));
+    CHECK_EQUAL(0, output[0].time_ms);
+    CHECK_EQUAL(series[SERIES_SAMPLES - 1].time_ms, output[99].time_ms);
+    CHECK(contains(output, 100, series[4321].time_ms));
+    CHECK(contains(output, 100, series[7777].time_ms));
+    for (size_t i = 1; i < 100; i++) CHECK(output[i].time_ms > output[i - 1].time_ms);
+
+    // Too few points to downsample copies the start of the input
+    CHECK_EQUAL(2, ccs811_downsample(series, SERIES_SAMPLES, output, 2, CCS811_FIELD_eCO2));
+    CHECK_EQUAL(1000, output[1].time_ms);
+}
+
+TEST(streaming_downsampler_keeps_peaks_and_ends) {
+    static ccs811_sample_t series[SERIES_SAMPLES];
+    make_peaked_series(series);
+    CCS811Downsampler<100> downsampler;
+    ccs811_sample_t output[SERIES_SAMPLES / 100 + 2];
+    size_t kept = 0;
+    for (uint32_t i = 0; i < SERIES_SAMPLES; i++) kept += downsampler.add(series[i], output[kept]);
+    kept += downsampler.flush(output + kept);
+
+    CHECK_NEAR(SERIES_SAMPLES / 100, kept, 2);
+    CHECK_EQUAL(0, output[0].time_ms);
+    CHECK_EQUAL(series[SERIES_SAMPLES - 1].time_ms, output[kept - 1].time_ms);
+    CHECK(contains(output, kept, series[4321].time_ms));
+    CHECK(contains(output, kept, series[7777].time_ms));
+}
+
+TEST(streaming_downsampler_keeps_a_peak_in_the_last_bucket) {
+    // Samples 1-4 fill the candidate bucket and nothing follows it, with the peak in the middle
+    const uint16_t eCO2[] = {400, 410, 1800, 420, 430};
+    CCS811Downsampler<4> downsampler;
+    ccs811_sample_t output[4];
+    size_t kept = 0;
+    for (uint32_t i = 0; i < 5; i++) kept += downsampler.add({1000 * i, eCO2[i], 0}, output[kept]);
+    CHECK_EQUAL(1, kept);
+    kept += downsampler.flush(output + kept);
+
+    CHECK_EQUAL(3, kept);
+    CHECK_EQUAL(0, output[0].time_ms);
+    CHECK_EQUAL(1800, output[1].eCO2);
+    CHECK_EQUAL(4000, output[2].time_ms);
+
+    // A single trailing candidate is the last sample and is kept once
+    CHECK(downsampler.add({0, 400, 0}, output[0]));
+    CHECK(not downsampler.add({1000, 410, 0}, output[0]));
+    CHECK_EQUAL(1, downsampler.flush(output));
+    CHECK_EQUAL(1000, output[0].time_ms);
+}
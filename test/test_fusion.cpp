@@ -0,0 +1,120 @@
+#include "CCS811_fusion.h"
+#include "test.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// FUSION
+
+TEST(fuse_rejects_an_outlier_and_weights_by_health) {
+    const uint16_t values[] = {600, 620, 610, 1800};
+    const uint8_t health[] = {255, 255, 128, 255};
+    ccs811_fused_sample_t fused;
+    CHECK(ccs811_fuse(values, health, 4, fused));
+    CHECK_EQUAL(3, fused.inliers);
+    CHECK_EQUAL(615, fused.median);
+    CHECK_EQUAL(610, fused.value);
+}
+
+TEST(fuse_ignores_unhealthy_sensors) {
+    const uint16_t values[] = {600, 4000, 620};
+    const uint8_t health[] = {255, 0, 255};
+    ccs811_fused_sample_t fused;
+    CHECK(ccs811_fuse(values, health, 3, fused));
+    CHECK_EQUAL(2, fused.inliers);
+    CHECK_EQUAL(610, fused.value);
+
+    const uint8_t none[] = {0, 0, 0};
+    CHECK(not ccs811_fuse(values, none, 3, fused));
+    CHECK_EQUAL(0, fused.inliers);
+}
+
+TEST(fuse_falls_back_to_the_median_when_every_reading_is_rejected) {
+    const uint16_t values[] = {400, 1000};
+    const uint8_t health[] = {255, 255};
+    const ccs811_fusion_config_t config = {0.5, 0};
+    ccs811_fused_sample_t fused;
+    CHECK(ccs811_fuse(values, health, 2, fused, config));
+    CHECK_EQUAL(0, fused.inliers);
+    CHECK_EQUAL(700, fused.median);
+    CHECK_EQUAL(700, fused.value);
+}
+
+TEST(fuse_batch_matches_fusing_each_room) {
+    const uint8_t sensors = 3;
+    const size_t rooms = 4;
+    const uint16_t values[sensors * rooms] = {400, 800, 1200, 500, 410, 2000, 1210, 520, 420, 810, 1190, 530};
+    const uint8_t health[sensors * rooms] = {255, 255, 0, 255, 255, 255, 0, 255, 255, 255, 0, 64};
+    ccs811_fused_sample_t fused[rooms];
+    CHECK_EQUAL(3, ccs811_fuse_batch(values, health, sensors, rooms, fused));
+    CHECK_EQUAL(0, fused[2].inliers);
+
+    for (size_t room = 0; room < rooms; room++) {
+        if (room == 2) continue;
+        uint16_t room_values[sensors];
+        uint8_t room_health[sensors];
+        for (uint8_t sensor = 0; sensor < sensors; sensor++) {
+            room_values[sensor] = values[sensor * rooms + room];
+            room_health[sensor] = health[sensor * rooms + room];
+        }
+        ccs811_fused_sample_t expected;
+        CHECK(ccs811_fuse(room_values, room_health, sensors, expected));
+        CHECK_EQUAL(expected.value, fused[room].value);
+        CHECK_EQUAL(expected.inliers, fused[room].inliers);
+    }
+    CHECK_EQUAL(805, fused[1].value);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TIME ALIGNMENT
+
+TEST(resampler_interpolates_onto_the_grid) {
+    CCS811Resampler resampler(0, 1000, 5000);
+    ccs811_grid_sample_t point;
+    CHECK(resampler.add({1500, 400, 10}));
+    CHECK(not resampler.next(point));
+    CHECK(resampler.add({3500, 800, 50}));
+
+    CHECK(resampler.next(point));
+    CHECK_EQUAL(2000, point.time_ms);
+    CHECK(not point.gap);
+    CHECK_EQUAL(500, point.eCO2);
+    CHECK_EQUAL(20, point.eTVOC);
+    CHECK(resampler.next(point));
+    CHECK_EQUAL(3000, point.time_ms);
+    CHECK_EQUAL(700, point.eCO2);
+    CHECK(not resampler.next(point));
+
+    CHECK(resampler.add({10000, 900, 60}));
+    uint8_t gaps = 0;
+    while (resampler.next(point)) gaps += point.gap;
+    CHECK_EQUAL(6, gaps);
+    CHECK_EQUAL(9000, point.time_ms);
+}
+
+TEST(resampler_holds_samples_until_pending_points_are_taken) {
+    CCS811Resampler resampler(0, 1000, 5000);
+    ccs811_grid_sample_t point;
+    CHECK(resampler.add({0, 400, 0}));
+    CHECK(resampler.add({3000, 700, 0}));
+
+    // Three grid points are pending; a new sample would lose the one they are interpolated from
+    CHECK(not resampler.add({4000, 1000, 0}));
+    CHECK(resampler.next(point));
+    CHECK(not resampler.add({4000, 1000, 0}));
+
+    uint32_t previous_ms = point.time_ms;
+    uint8_t points = 1;
+    while (resampler.next(point)) {
+        CHECK(point.time_ms > previous_ms);
+        CHECK_EQUAL(400 + point.time_ms / 10, point.eCO2);
+        previous_ms = point.time_ms;
+        points++;
+    }
+    CHECK_EQUAL(3, points);
+
+    // Drained, the sample is accepted and the grid carries on from it
+    CHECK(resampler.add({4000, 1000, 0}));
+    CHECK(resampler.next(point));
+    CHECK_EQUAL(3000, point.time_ms);
+    CHECK_EQUAL(700, point.eCO2);
+    CHECK(not resampler.add({3500, 800, 0}));
+}
@@ -0,0 +1,83 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "CCS811_history.h"
+#include "test.h"
+
+TEST(history_keeps_samples_oldest_first) {
+    CCS811History<4> history;
+    CHECK_EQUAL(0, history.size());
+    for (uint32_t i = 0; i < 3; i++) history.append(1000 * i, 400 + i, i, 0x98);
+    CHECK_EQUAL(3, history.size());
+    CHECK_EQUAL(0, history.time_ms(0));
+    CHECK_EQUAL(402, history.eCO2(2));
+    CHECK_EQUAL(0x98, history.status(1));
+}
+
+TEST(history_overwrites_the_oldest_sample_when_full) {
+    CCS811History<4> history;
+    for (uint32_t i = 0; i < 6; i++) history.append(1000 * i, 400 + i, i, 0);
+    CHECK_EQUAL(4, history.size());
+    CHECK_EQUAL(6, history.get_write_count());
+    CHECK_EQUAL(2000, history.time_ms(0));
+    CHECK_EQUAL(5, history.eTVOC(3));
+
+    history.clear();
+    CHECK_EQUAL(0, history.size());
+}
+
+TEST(history_window_and_max_span_the_wrap) {
+    CCS811History<8> history;
+    const uint16_t eCO2[] = {400, 900, 450, 500, 700, 420, 410, 800, 430, 600, 440};
+    for (uint32_t i = 0; i < sizeof(eCO2) / sizeof(eCO2[0]); i++) history.append(1000 * i, eCO2[i], eCO2[i] / 10, 0);
+
+    // Held: samples 3 to 10, physically split after sample 7
+    size_t first;
+    CHECK_EQUAL(5, history.window(4000, 8500, first));
+    CHECK_EQUAL(1, first);
+    CHECK_EQUAL(800, history.max_eCO2(first, 5));
+    CHECK_EQUAL(80, history.max_eTVOC(first, 5));
+    CHECK_EQUAL(600, history.max_eCO2(5, 3));
+    CHECK_EQUAL(0, history.window(20000, 30000, first));
+}
+
+TEST(history_reader_detects_concurrent_overwrites) {
+    // Every sample stores its index in all columns, so a scan that raced with the writer shows up as a mismatch
+    static CCS811History<256> history;
+    const uint32_t samples = 200000;
+    history.clear();
+    std::atomic<bool> done{false};
+
+    // Bursts with pauses between them, so some scans run entirely inside a pause and are accepted
+    std::thread writer([&]() {
+        for (uint32_t i = 1; i <= samples; i++) {
+            history.append(i, (uint16_t)i, (uint16_t)i, 0);
+            if (i % 64 == 0) std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+        done = true;
+    });
+
+    uint32_t clean_scans = 0;
+    uint32_t torn_clean_scans = 0;
+    while (not done) {
+        uint32_t sequence = history.read_begin();
+        uint32_t count = history.get_write_count();
+        if (count < 256) continue;
+        // Index 0 must be the oldest sample held, and the rest must follow it in order
+        bool consistent = true;
+        for (size_t i = 0; i < 256; i++) {
+            uint32_t time_ms = history.time_ms(i);
+            consistent = consistent and time_ms == count - 255 + i;
+            consistent = consistent and history.eCO2(i) == (uint16_t)time_ms and history.eTVOC(i) == (uint16_t)time_ms;
+        }
+        if (history.read_retry(sequence)) continue;
+        clean_scans++;
+        if (not consistent) torn_clean_scans++;
+    }
+    writer.join();
+
+    CHECK(clean_scans > 0);
+    CHECK_EQUAL(0, torn_clean_scans);
+    CHECK_EQUAL(samples, history.get_write_count());
+    CHECK_EQUAL(samples, history.time_ms(255));
+}
@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+
+static test_case_t* first_test = nullptr;
+static test_case_t* last_test = nullptr;
+static int current_failures = 0;
+
+void test_register(test_case_t* test) {
+    if (last_test)
+        last_test->next = test;
+    else
+        first_test = test;
+    last_test = test;
+}
+
+void test_fail(const char* file, int line, const char* message) {
+    printf("  %s:%d: %s\n", file, line, message);
+    current_failures++;
+}
+
+void test_fail_equal(const char* file, int line, const char* expression, long long expected, long long actual) {
+    printf("  %s:%d: %s == %lld, expected %lld\n", file, line, expression, actual, expected);
+    current_failures++;
+}
+
+void test_fail_near(const char* file, int line, const char* expression, double expected, double actual) {
+    printf("  %s:%d: %s == %g, expected %g\n", file, line, expression, actual, expected);
+    current_failures++;
+}
+
+/**
+ * Run every registered test, or only those whose name contains the first argument.
+ */
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    int failed = 0;
+
+    for (test_case_t* test = first_test; test; test = test->next) {
+        if (filter and not strstr(test->name, filter)) continue;
+        current_failures = 0;
+        test->function();
+        run++;
+        if (current_failures) failed++;
+        printf("%s %s\n", current_failures ? "FAIL" : "PASS", test->name);
+    }
+
+    printf("%d tests, %d failed\n", run, failed);
+    return failed ? 1 : 0;
+}
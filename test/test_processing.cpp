@@ -0,0 +1,212 @@
+#include <Arduino.h>
+#include <MockTwoWireDevice.h>
+#include <string.h>
+#include "CCS811_driver.h"
+#include "CCS811_processing.h"
+#include "CCS811_simulator.h"
+#include "test.h"
+
+static ccs811_raw_data_t raw_sample(uint8_t current_uA, uint16_t adc_reading) {
+    ccs811_raw_data_t data;
+    data.raw[0] = 0;
+    data.raw[1] = 0;
+    data.current_uA = current_uA;
+    data.adc_reading = adc_reading;
+    return data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// RESISTANCE
+
+TEST(resistance_table_matches_the_divide) {
+    const uint16_t readings[] = {1, 155, 512, 1023};
+    for (uint8_t current = 1; current < 64; current++) {
+        for (uint16_t adc : readings) {
+            double expected = adc * CCS811_ADC_REFERENCE_VOLTAGE / CCS811_ADC_FULL_SCALE / (current * 1e-6);
+            CHECK_NEAR(expected, ccs811_resistance(raw_sample(current, adc)), expected * 1e-5);
+        }
+    }
+}
+
+TEST(resistance_is_zero_without_current) {
+    CHECK_EQUAL(0, ccs811_resistance(raw_sample(0, 1023)));
+    CHECK_EQUAL(0, ccs811_resistance(raw_sample(20, 0)));
+}
+
+TEST(resistances_match_single_conversions) {
+    const size_t count = 64 * 3;
+    ccs811_raw_data_t data[count];
+    float resistances[count];
+    for (size_t i = 0; i < count; i++) data[i] = raw_sample(i % 64, (uint16_t)(i * 37 % 1024));
+    ccs811_resistances(data, resistances, count);
+    for (size_t i = 0; i < count; i++) CHECK_EQUAL(ccs811_resistance(data[i]), resistances[i]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// RAW MODE PROCESSING
+
+TEST(raw_processor_starts_from_clean_air) {
+    CCS811RawProcessor processor;
+    CHECK(processor.update(raw_sample(20, 600)));
+    CHECK_NEAR(ccs811_resistance(raw_sample(20, 600)), processor.get_baseline(), 1e-3);
+    CHECK_EQUAL(0, processor.get_eTVOC());
+    CHECK_EQUAL(CCS811_MIN_eCO2, processor.get_eCO2());
+    CHECK_EQUAL(1, processor.get_sample_count());
+}
+
+TEST(raw_processor_rejects_samples_without_current) {
+    CCS811RawProcessor processor;
+    CHECK(not processor.update(raw_sample(0, 600)));
+    CHECK(not processor.update(raw_sample(20, 0)));
+    CHECK_EQUAL(0, processor.get_sample_count());
+    CHECK_EQUAL(0, processor.get_baseline());
+}
+
+TEST(raw_processor_reports_voc_when_resistance_drops) {
+    CCS811RawProcessor processor;
+    processor.update(raw_sample(20, 600));
+    CHECK(processor.update(raw_sample(20, 300)));
+
+    // baseline / resistance - 1 is just under 1, so eTVOC is just under the model's scale
+    CHECK(processor.get_eTVOC() > 95 and processor.get_eTVOC() <= 100);
+    CHECK_NEAR(CCS811_MIN_eCO2 + 2 * processor.get_eTVOC(), processor.get_eCO2(), 2);
+}
+
+TEST(raw_processor_baseline_rises_fast_and_falls_slowly) {
+    CCS811RawProcessor processor;
+    processor.update(raw_sample(20, 500));
+    float start = processor.get_baseline();
+
+    for (int i = 0; i < 100; i++) processor.update(raw_sample(20, 600));
+    float risen = processor.get_baseline();
+    CHECK_NEAR(ccs811_resistance(raw_sample(20, 600)), risen, 0.01 * risen);
+
+    for (int i = 0; i < 100; i++) processor.update(raw_sample(20, 500));
+    CHECK(processor.get_baseline() > risen - 0.02 * (risen - start));
+}
+
+TEST(raw_processor_clamps_to_the_sensor_range) {
+    CCS811RawProcessor processor;
+    processor.update(raw_sample(20, 1000));
+    processor.update(raw_sample(20, 5));
+    CHECK_EQUAL(CCS811_MAX_eTVOC, processor.get_eTVOC());
+    CHECK_EQUAL(CCS811_MIN_eCO2 + 2 * CCS811_MAX_eTVOC, processor.get_eCO2());
+}
+
+TEST(raw_processor_restores_a_saved_baseline) {
+    CCS811RawProcessor processor;
+    processor.set_baseline(ccs811_resistance(raw_sample(20, 600)));
+    processor.update(raw_sample(20, 300));
+    CHECK(processor.get_eTVOC() > 95);
+
+    processor.reset();
+    CHECK_EQUAL(0, processor.get_baseline());
+    CHECK_EQUAL(0, processor.get_sample_count());
+}
+
+TEST(raw_processor_follows_a_simulated_raw_mode_sensor) {
+    TwoWire bus;
+    ccs811_simulator_config_t config = CCS811_DEFAULT_SIMULATOR_CONFIG;
+    config.walk_step = 0;
+    CCS811Simulator simulator(config);
+    simulator.power_on(true);
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &simulator);
+
+    CCS811 sensor;
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);
+    ccs811_measure_config_t measure;
+    measure.raw = 0;
+    measure.drive_mode = CCS811_CONSTANT_POWER_250MS;
+    sensor.write(measure);
+
+    CCS811RawProcessor processor;
+    ccs811_raw_data_t data;
+    for (int i = 0; i < 40; i++) {
+        arduino_host_advance_ms(CCS811_CONSTANT_POWER_250MS_SAMPLE_PERIOD_MS);
+        CHECK(sensor.read(data));
+        processor.update(data);
+    }
+    CHECK_EQUAL(40, processor.get_sample_count());
+    CHECK_EQUAL(0, processor.get_eTVOC());
+
+    simulator.set_air_quality(CCS811_MIN_eCO2, 400);
+    for (int i = 0; i < 4; i++) {
+        arduino_host_advance_ms(CCS811_CONSTANT_POWER_250MS_SAMPLE_PERIOD_MS);
+        CHECK(sensor.read(data));
+        processor.update(data);
+    }
+    CHECK(processor.get_eTVOC() > 0);
+    CHECK(processor.get_eCO2() > CCS811_MIN_eCO2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// BATCH DECODING
+
+TEST(decode_frames_matches_the_register_layout) {
+    const size_t count = 37;  // Not a multiple of any vector width
+    uint8_t frames[count * CCS811_FRAME_SIZE];
+    uint32_t random = 12345;
+    for (size_t i = 0; i < sizeof(frames); i++) {
+        random = random * 1103515245 + 12345;
+        frames[i] = random >> 24;
+    }
+
+    uint16_t eCO2[count], eTVOC[count], adc[count];
+    uint8_t status[count], error[count], current[count];
+    ccs811_frame_columns_t columns = {eCO2, eTVOC, status, error, current, adc};
+    ccs811_decode_frames(frames, count, columns);
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* frame = frames + i * CCS811_FRAME_SIZE;
+        CHECK_EQUAL(frame[0] * 256 + frame[1], eCO2[i]);
+        CHECK_EQUAL(frame[2] * 256 + frame[3], eTVOC[i]);
+        CHECK_EQUAL(frame[4], status[i]);
+        CHECK_EQUAL(frame[5], error[i]);
+        uint16_t raw = frame[6] * 256 + frame[7];
+        CHECK_EQUAL(raw >> 10, current[i]);
+        CHECK_EQUAL(raw & 0x3FF, adc[i]);
+    }
+
+    // Null columns are skipped in the vector steps as well as the remainder
+    memset(eTVOC, 0, sizeof(eTVOC));
+    ccs811_frame_columns_t some = {nullptr, eTVOC, nullptr, nullptr, nullptr, nullptr};
+    ccs811_decode_frames(frames, count, some);
+    for (size_t i = 0; i < count; i++) {
+        CHECK_EQUAL(frames[i * CCS811_FRAME_SIZE + 2] * 256 + frames[i * CCS811_FRAME_SIZE + 3], eTVOC[i]);
+    }
+}
+
+TEST(decode_frames_agrees_with_the_driver) {
+    const uint8_t frame[CCS811_FRAME_SIZE] = {0x04, 0xD2, 0x00, 0xFA, 0x98, 0x01, 0x50, 0x9B};
+    TwoWire bus;
+    MockTwoWireDevice device;
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &device);
+    device.set_register(0x20, CCS811_HARDWARE_ID);
+    device.set_register(0x02, frame, sizeof(frame));
+    CCS811 sensor;
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);
+    ccs811_all_data_t data;
+    CHECK(sensor.read(data));
+
+    uint16_t eCO2, eTVOC, adc;
+    uint8_t status, error, current;
+    ccs811_frame_columns_t columns = {&eCO2, &eTVOC, &status, &error, &current, &adc};
+    ccs811_decode_frames(frame, 1, columns);
+
+    CHECK_EQUAL(data.eCO2_ppb_reading.total, eCO2);
+    CHECK_EQUAL(data.eTVOC_ppm_reading.total, eTVOC);
+    CHECK_EQUAL(data.status.raw, status);
+    CHECK_EQUAL(data.error.raw, error);
+    CHECK_EQUAL(data.raw_data.current_uA, current);
+    CHECK_EQUAL(data.raw_data.adc_reading, adc);
+}
+
+TEST(decode_frames_skips_null_columns) {
+    const uint8_t frames[2 * CCS811_FRAME_SIZE] = {0x01, 0x90, 0, 0, 0, 0, 0, 0, 0x02, 0x00, 0, 0, 0, 0, 0, 0};
+    uint16_t eCO2[2] = {};
+    ccs811_frame_columns_t columns = {};
+    columns.eCO2 = eCO2;
+    ccs811_decode_frames(frames, 2, columns);
+    CHECK_EQUAL(400, eCO2[0]);
+    CHECK_EQUAL(512, eCO2[1]);
+}
@@ -0,0 +1,141 @@
+#include <Arduino.h>
+#include "CCS811_driver.h"
+#include "CCS811_scheduling.h"
+#include "CCS811_simulator.h"
+#include "test.h"
+
+static const uint32_t SETTLING_SAMPLES = 30;
+
+typedef struct {
+    ccs811_schedule_stats_t schedule;  // Scheduler's own counters
+    ccs811_simulator_stats_t sensor;   // Simulator counters
+    float period_ms;                   // Period the scheduler learned
+    uint32_t new_samples;              // Reads that returned a new sample
+    uint64_t age_ms;                   // Sum over settled samples of the age the scheduler reported
+    uint64_t true_age_ms;              // Sum over settled samples of the time since the sample actually became ready
+    uint32_t max_true_age_ms;          // Oldest actual age of a settled sample
+    uint32_t max_age_error_ms;         // Largest difference between reported and actual age of a settled sample
+} drift_run_t;
+
+/**
+ * Read a simulated sensor whose clock runs at `period_scale` of nominal in 1 s mode for `duration_ms`, whenever the
+ * scheduler says a read is due. Ages are compared once the scheduler has had SETTLING_SAMPLES samples to lock on.
+ */
+static drift_run_t run_with_drift(float period_scale, uint32_t duration_ms) {
+    ccs811_simulator_config_t config = CCS811_DEFAULT_SIMULATOR_CONFIG;
+    config.period_scale = period_scale;
+    TwoWire bus;
+    CCS811Simulator simulator(config);
+    CCS811 sensor;
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &simulator);
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);
+    sensor.start_application_mode();
+    ccs811_measure_config_t measure;
+    measure.raw = 0;
+    measure.drive_mode = CCS811_CONSTANT_POWER_1SEC;
+    sensor.write(measure);
+
+    uint64_t period_us = (uint64_t)(1000000.0 * period_scale + 0.5);
+    CCS811ReadScheduler scheduler(CCS811_CONSTANT_POWER_1SEC_SAMPLE_PERIOD_MS);
+    drift_run_t run = {};
+    uint32_t end_ms = millis() + duration_ms;
+    while ((int32_t)(millis() - end_ms) < 0) {
+        uint32_t next_ms = scheduler.get_next_read_ms();
+        if ((int32_t)(next_ms - millis()) > 0) arduino_host_advance_ms(next_ms - millis());
+
+        uint64_t ready_us = simulator.get_next_sample_us() - period_us;
+        uint32_t total_age_ms = scheduler.get_stats().total_age_ms;
+        ccs811_all_data_t data;
+        if (not sensor.read(data) or not scheduler.observe(millis(), data.status)) continue;
+        if (++run.new_samples <= SETTLING_SAMPLES) continue;
+
+        uint32_t age_ms = scheduler.get_stats().total_age_ms - total_age_ms;
+        uint32_t true_age_ms = (uint32_t)((arduino_host_time_us() - ready_us) / 1000);
+        uint32_t error_ms = age_ms > true_age_ms ? age_ms - true_age_ms : true_age_ms - age_ms;
+        run.age_ms += age_ms;
+        run.true_age_ms += true_age_ms;
+        if (true_age_ms > run.max_true_age_ms) run.max_true_age_ms = true_age_ms;
+        if (error_ms > run.max_age_error_ms) run.max_age_error_ms = error_ms;
+    }
+    run.schedule = scheduler.get_stats();
+    run.sensor = simulator.get_stats();
+    run.period_ms = scheduler.get_period_ms();
+    return run;
+}
+
+static double mean_age_error_ms(const drift_run_t& run) {
+    return ((double)run.age_ms - (double)run.true_age_ms) / (run.new_samples - SETTLING_SAMPLES);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(scheduler_locks_onto_a_sensor_on_time) {
+    drift_run_t run = run_with_drift(1.0f, 600000);
+    CHECK_EQUAL(run.sensor.samples, run.new_samples);
+    CHECK_EQUAL(0, run.sensor.overwritten_samples);
+    CHECK_EQUAL(run.sensor.overwritten_samples, run.schedule.missed_samples);
+    CHECK_NEAR(1000, run.period_ms, 1);
+    CHECK(run.max_true_age_ms <= CCS811_DEFAULT_READ_RETRY_MS);
+    CHECK(run.max_age_error_ms <= CCS811_DEFAULT_READ_MARGIN_MS);
+}
+
+TEST(scheduler_follows_a_slow_sensor) {
+    drift_run_t run = run_with_drift(1.013f, 600000);
+    CHECK_EQUAL(run.sensor.samples, run.new_samples);
+    CHECK_EQUAL(0, run.sensor.overwritten_samples);
+    CHECK_EQUAL(run.sensor.overwritten_samples, run.schedule.missed_samples);
+    CHECK_NEAR(1013, run.period_ms, 2);
+    CHECK(run.max_true_age_ms <= CCS811_DEFAULT_READ_RETRY_MS);
+    CHECK(run.max_age_error_ms <= CCS811_DEFAULT_READ_RETRY_MS);
+    CHECK_NEAR(0, mean_age_error_ms(run), 5);
+}
+
+TEST(scheduler_catches_up_with_a_fast_sensor) {
+    const float scales[] = {0.987f, 0.95f};
+    for (float scale : scales) {
+        drift_run_t run = run_with_drift(scale, 600000);
+        CHECK_EQUAL(run.sensor.samples, run.new_samples);
+        CHECK_EQUAL(0, run.sensor.overwritten_samples);
+        CHECK_EQUAL(run.sensor.overwritten_samples, run.schedule.missed_samples);
+        CHECK_NEAR(1000 * scale, run.period_ms, 2);
+        CHECK(run.max_true_age_ms <= 2 * CCS811_DEFAULT_READ_RETRY_MS);
+        CHECK(run.max_age_error_ms <= CCS811_DEFAULT_READ_RETRY_MS);
+        CHECK_NEAR(0, mean_age_error_ms(run), 5);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// LATENCY
+
+TEST(latency_tracker_buckets_each_stage) {
+    CCS811LatencyTracker tracker(100);
+    tracker.record({1000, 1003, 1003}, 1010);
+    tracker.record({2000, 2020, 2021}, 2150);
+    CHECK_EQUAL(2, tracker.get_samples());
+    CHECK_EQUAL(1, tracker.get_violations());
+    CHECK_EQUAL(1, tracker.get_count(CCS811_LATENCY_READ, 2));
+    CHECK_EQUAL(1, tracker.get_count(CCS811_LATENCY_READ, 5));
+    CHECK_EQUAL(1, tracker.get_count(CCS811_LATENCY_ENQUEUE, 0));
+    CHECK_EQUAL(1, tracker.get_count(CCS811_LATENCY_ENQUEUE, 1));
+    CHECK_EQUAL(0, tracker.get_count(CCS811_LATENCY_READ, CCS811_LATENCY_BUCKETS));
+    CHECK_EQUAL(255, tracker.get_quantile_ms(CCS811_LATENCY_END_TO_END, 1));
+
+    tracker.clear();
+    CHECK_EQUAL(0, tracker.get_samples());
+    CHECK_EQUAL(0, tracker.get_quantile_ms(CCS811_LATENCY_READ, 0.5f));
+}
+
+TEST(latency_tracker_counts_past_16_bits) {
+    CCS811LatencyTracker tracker(100);
+    uint32_t ready_ms = 0;
+    for (uint32_t i = 0; i < 202000; i++) {
+        uint32_t latency_ms = i % 101 == 100 ? 200 : 3;
+        tracker.record({ready_ms, ready_ms + latency_ms, ready_ms + latency_ms}, ready_ms + latency_ms);
+        ready_ms += 1000;
+    }
+    CHECK_EQUAL(200000, tracker.get_count(CCS811_LATENCY_READ, 2));
+    CHECK_EQUAL(2000, tracker.get_count(CCS811_LATENCY_READ, 8));
+    CHECK_EQUAL(3, tracker.get_quantile_ms(CCS811_LATENCY_READ, 0.98f));
+    CHECK_EQUAL(255, tracker.get_quantile_ms(CCS811_LATENCY_READ, 0.995f));
+    CHECK_EQUAL(2000, tracker.get_violations());
+}
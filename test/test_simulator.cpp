@@ -0,0 +1,364 @@
+#include <Arduino.h>
+#include "CCS811_driver.h"
+#include "CCS811_simulator.h"
+#include "test.h"
+
+/**
+ * The driver talking to a simulated sensor on its own bus.
+ */
+struct simulator_fixture {
+    TwoWire bus;
+    CCS811Simulator simulator;
+    CCS811 sensor;
+
+    simulator_fixture(const ccs811_simulator_config_t& config = CCS811_DEFAULT_SIMULATOR_CONFIG)
+        : simulator(config) {
+        bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &simulator);
+        sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);
+    }
+
+    void measure(uint8_t drive_mode, bool interrupt = false) {
+        sensor.start_application_mode();
+        ccs811_measure_config_t config;
+        config.raw = 0;
+        config.drive_mode = drive_mode;
+        config.interrupt_on_data_ready_enabled = interrupt;
+        sensor.write(config);
+    }
+};
+
+static ccs811_simulator_config_t constant_config(uint16_t eCO2, uint16_t eTVOC) {
+    ccs811_simulator_config_t config = CCS811_DEFAULT_SIMULATOR_CONFIG;
+    config.eCO2 = eCO2;
+    config.eTVOC = eTVOC;
+    config.walk_step = 0;
+    return config;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(simulator_powers_on_in_boot_mode) {
+    simulator_fixture fixture;
+    ccs811_status_t status;
+    CHECK(fixture.sensor.read(status));
+    CHECK(not status.firmware_is_in_application_mode);
+    CHECK(status.application_firmware_loaded);
+    CHECK(not status.error_has_occurred);
+
+    ccs811_hardware_version_t hardware;
+    ccs811_firmware_boot_version_t boot;
+    CHECK(fixture.sensor.read(hardware));
+    CHECK(fixture.sensor.read(boot));
+    CHECK_EQUAL(CCS811_SIMULATOR_HARDWARE_VERSION, hardware.raw);
+    CHECK_EQUAL(1, boot.major);
+
+    // Application registers do not exist in boot mode
+    ccs811_measure_config_t config;
+    config.raw = 0x10;
+    fixture.sensor.write(config);
+    CHECK(fixture.simulator.get_error() & 0x01);
+}
+
+TEST(simulator_samples_at_drive_mode_period) {
+    simulator_fixture fixture(constant_config(612, 37));
+    fixture.measure(CCS811_CONSTANT_POWER_1SEC);
+    CHECK(fixture.simulator.is_application_mode());
+
+    ccs811_air_quality_data_t data;
+    arduino_host_advance_ms(999);
+    CHECK_EQUAL(CCS811_READ_NO_NEW_DATA, fixture.sensor.read_new(data));
+
+    arduino_host_advance_ms(1);
+    CHECK_EQUAL(CCS811_READ_NEW_DATA, fixture.sensor.read_new(data));
+    CHECK_EQUAL(612, data.eCO2_reading.total);
+    CHECK_EQUAL(37, data.eTVOC_reading.total);
+    CHECK_EQUAL(CCS811_READ_NO_NEW_DATA, fixture.sensor.read_new(data));
+
+    fixture.measure(CCS811_PULSED_60SEC);
+    arduino_host_advance_ms(59999);
+    CHECK_EQUAL(CCS811_READ_NO_NEW_DATA, fixture.sensor.read_new(data));
+    arduino_host_advance_ms(1);
+    CHECK_EQUAL(CCS811_READ_NEW_DATA, fixture.sensor.read_new(data));
+}
+
+TEST(simulator_counts_overwritten_samples) {
+    simulator_fixture fixture;
+    fixture.measure(CCS811_CONSTANT_POWER_1SEC);
+    arduino_host_advance_ms(3500);
+
+    ccs811_air_quality_data_t data;
+    CHECK_EQUAL(CCS811_READ_NEW_DATA, fixture.sensor.read_new(data));
+    ccs811_simulator_stats_t stats = fixture.simulator.get_stats();
+    CHECK_EQUAL(3, stats.samples);
+    CHECK_EQUAL(2, stats.overwritten_samples);
+}
+
+TEST(simulator_raw_mode_updates_raw_data_only) {
+    simulator_fixture fixture(constant_config(500, 20));
+    fixture.measure(CCS811_CONSTANT_POWER_250MS);
+    fixture.simulator.set_air_quality(900, 150);
+    arduino_host_advance_ms(250);
+
+    ccs811_all_data_t data;
+    CHECK(fixture.sensor.read(data));
+    CHECK(data.status.data_ready);
+    CHECK_EQUAL(900, data.eCO2_ppb_reading.total);  // Written directly, not by a sample
+    CHECK_EQUAL(20, data.raw_data.current_uA);
+    CHECK_EQUAL(600 - 150 / 2, data.raw_data.adc_reading);
+}
+
+TEST(simulator_walk_stays_in_range) {
+    ccs811_simulator_config_t config = CCS811_DEFAULT_SIMULATOR_CONFIG;
+    config.walk_step = 200;
+    simulator_fixture fixture(config);
+    fixture.measure(CCS811_CONSTANT_POWER_1SEC);
+
+    for (int i = 0; i < 2000; i++) {
+        arduino_host_advance_ms(1000);
+        ccs811_air_quality_data_t data;
+        CHECK_EQUAL(CCS811_READ_NEW_DATA, fixture.sensor.read_new(data));
+        CHECK(data.eCO2_reading.total >= 400 and data.eCO2_reading.total <= 8192);
+        CHECK(data.eTVOC_reading.total <= 1187);
+    }
+}
+
+TEST(simulator_flags_unsupported_drive_mode) {
+    simulator_fixture fixture;
+    fixture.measure(CCS811_CONSTANT_POWER_1SEC);
+    fixture.measure(6);
+    CHECK_EQUAL(CCS811_CONSTANT_POWER_1SEC, fixture.simulator.get_drive_mode());
+
+    ccs811_error_t error;
+    CHECK(fixture.sensor.read(error));
+    CHECK(error.measurement_mode_unsupported);
+    CHECK(fixture.sensor.read(error));
+    CHECK_EQUAL(0, error.raw);  // ERROR_ID clears on read
+}
+
+TEST(simulator_keeps_baseline_and_environment) {
+    simulator_fixture fixture;
+    fixture.measure(CCS811_PULSED_10SEC);
+
+    ccs811_baseline_t baseline;
+    baseline.raw[0] = 0x12;
+    baseline.raw[1] = 0x34;
+    CHECK(fixture.sensor.write(baseline));
+    baseline.raw[0] = baseline.raw[1] = 0;
+    CHECK(fixture.sensor.read(baseline));
+    CHECK_EQUAL(0x12, baseline.raw[0]);
+    CHECK_EQUAL(0x34, baseline.raw[1]);
+
+    fixture.sensor.write_environmental_data(30.0, 40.0);
+    CHECK_EQUAL(0x50, fixture.simulator.get_environment()[0]);  // 40 %RH * 512 = 0x5000
+    CHECK_EQUAL(0x0A, fixture.simulator.get_environment()[2]);  // 5 degC above 25 * 512 = 0x0A00
+}
+
+TEST(simulator_firmware_update_sequence) {
+    simulator_fixture fixture;
+    CHECK(fixture.sensor.start_application_erase());
+    ccs811_status_t status;
+    fixture.sensor.read(status);
+    CHECK(not status.application_firmware_erase_completed);
+
+    arduino_host_advance_ms(CCS811_DEFAULT_SIMULATOR_CONFIG.erase_ms);
+    fixture.sensor.read(status);
+    CHECK(status.application_firmware_erase_completed);
+    CHECK(not status.application_firmware_loaded);
+
+    fixture.sensor.start_application_mode();
+    CHECK(not fixture.simulator.is_application_mode());
+
+    ccs811_application_data_t block = {};
+    for (int i = 0; i < 4; i++) CHECK(fixture.sensor.write(block));
+    CHECK_EQUAL(36, fixture.simulator.get_application_data_bytes());
+
+    fixture.sensor.start_application_verify();
+    arduino_host_advance_ms(CCS811_DEFAULT_SIMULATOR_CONFIG.verify_ms);
+    fixture.sensor.read(status);
+    CHECK(status.application_firmware_verified);
+    CHECK(status.application_firmware_loaded);
+
+    fixture.sensor.start_application_mode();
+    CHECK(fixture.simulator.is_application_mode());
+}
+
+TEST(simulator_software_reset_returns_to_boot_mode) {
+    simulator_fixture fixture;
+    fixture.measure(CCS811_CONSTANT_POWER_1SEC);
+    CHECK(fixture.simulator.is_application_mode());
+
+    CHECK(fixture.sensor.reset());
+    CHECK(not fixture.simulator.is_application_mode());
+    CHECK_EQUAL(CCS811_IDLE_MODE, fixture.simulator.get_drive_mode());
+}
+
+TEST(simulator_asserts_interrupt_on_data_ready) {
+    simulator_fixture fixture;
+    fixture.measure(CCS811_CONSTANT_POWER_1SEC, true);
+    CHECK(not fixture.simulator.is_interrupt_asserted());
+    arduino_host_advance_ms(1000);
+    CHECK(fixture.simulator.is_interrupt_asserted());
+
+    ccs811_air_quality_data_t data;
+    fixture.sensor.read_new(data);
+    CHECK(not fixture.simulator.is_interrupt_asserted());
+}
+
+TEST(simulator_fault_injection_is_reproducible) {
+    ccs811_simulator_config_t config = CCS811_DEFAULT_SIMULATOR_CONFIG;
+    config.nack_per_mille = 300;
+    config.latency_us = 250;
+
+    uint32_t failures[2] = {};
+    for (int run = 0; run < 2; run++) {
+        simulator_fixture fixture(config);
+        fixture.sensor.set_comms_retry_policy(0, 0);
+        uint64_t start_us = arduino_host_time_us();
+        fixture.simulator.clear_stats();
+        for (int i = 0; i < 1000; i++) failures[run] += not fixture.sensor.comms_check();
+
+        ccs811_simulator_stats_t stats = fixture.simulator.get_stats();
+        CHECK_EQUAL(stats.transactions * 250ULL, arduino_host_time_us() - start_us);
+        CHECK_EQUAL(stats.busy_us, arduino_host_time_us() - start_us);
+        CHECK_EQUAL(failures[run], stats.nacks);
+    }
+    CHECK_EQUAL(failures[0], failures[1]);
+    CHECK(failures[0] > 400 and failures[0] < 600);  // Two transactions per read, each failing 30% of the time
+}
+
+TEST(simulator_replays_a_day_of_fleet_sampling_on_virtual_time) {
+    const uint16_t sensors = 1000;
+    const uint32_t samples = 24 * 60;  // One day at CCS811_PULSED_60SEC
+    static TwoWire buses[sensors];
+    static CCS811Simulator simulators[sensors];
+    static CCS811 drivers[sensors];
+
+    for (uint16_t i = 0; i < sensors; i++) {
+        simulators[i].power_on(true);
+        buses[i].attach(CCS811_DEFAULT_I2C_ADDRESS, &simulators[i]);
+        drivers[i].begin(CCS811_DEFAULT_I2C_ADDRESS, buses[i]);
+        ccs811_measure_config_t config;
+        config.raw = 0;
+        config.drive_mode = CCS811_PULSED_60SEC;
+        drivers[i].write(config);
+    }
+
+    uint32_t start_ms = millis();
+    for (uint32_t minute = 0; minute < samples; minute++) {
+        arduino_host_advance_ms(CCS811_PULSED_60SEC_SAMPLE_PERIOD_MS);
+        for (uint16_t i = 0; i < sensors; i++) {
+            ccs811_air_quality_data_t data;
+            drivers[i].read_new(data);
+        }
+    }
+
+    CHECK_EQUAL(24UL * 60 * 60 * 1000, millis() - start_ms);
+    for (uint16_t i = 0; i < sensors; i++) {
+        CHECK_EQUAL(samples, drivers[i].get_sample_sequence());
+        CHECK_EQUAL(0, simulators[i].get_stats().overwritten_samples);
+        buses[i].detach(CCS811_DEFAULT_I2C_ADDRESS);
+    }
+}
+
+TEST(simulator_scripted_stuck_bus_times_out) {
+    simulator_fixture fixture;
+    uint32_t now_ms = millis();
+    const ccs811_simulator_fault_t faults[] = {{now_ms + 100, 50, CCS811_SIMULATOR_STUCK_BUS, 25000}};
+    fixture.simulator.set_fault_script(faults, 1);
+    fixture.sensor.set_comms_retry_policy(0, 0);
+
+    CHECK(fixture.sensor.comms_check());
+    arduino_host_advance_ms(100);
+    CHECK(not fixture.sensor.comms_check());
+    CHECK_EQUAL(now_ms + 125, millis());  // The failed address write waited out the timeout
+    CHECK(not fixture.sensor.comms_check());
+    CHECK(fixture.sensor.comms_check());
+    CHECK_EQUAL(50000, fixture.simulator.get_stats().busy_us);
+}
+
+TEST(simulator_scripted_nack_burst) {
+    simulator_fixture fixture;
+    uint32_t now_ms = millis();
+    const ccs811_simulator_fault_t faults[] = {{now_ms, 1000, CCS811_SIMULATOR_NACKS, 1000}};
+    fixture.simulator.set_fault_script(faults, 1);
+    fixture.sensor.set_comms_retry_policy(0, 0);
+
+    CHECK(not fixture.sensor.comms_check());
+    arduino_host_advance_ms(1000);
+    CHECK(fixture.sensor.comms_check());
+}
+
+TEST(simulator_brown_out_cuts_burst_and_resets) {
+    simulator_fixture fixture;
+    fixture.measure(CCS811_CONSTANT_POWER_1SEC);
+    arduino_host_advance_ms(1000);
+    uint32_t now_ms = millis();
+    const ccs811_simulator_fault_t faults[] = {{now_ms, 20, CCS811_SIMULATOR_BROWN_OUT, 0}};
+    fixture.simulator.set_fault_script(faults, 1);
+
+    ccs811_all_data_t data;
+    CHECK(not fixture.sensor.read(data));
+    CHECK_EQUAL(CCS811_BUS_SHORT_READ, fixture.sensor.get_last_error());
+    CHECK(not fixture.simulator.is_application_mode());
+    CHECK_EQUAL(1, fixture.simulator.get_stats().brown_outs);
+
+    ccs811_status_t status;
+    CHECK(not fixture.sensor.read(status));  // Rebooting
+    CHECK_EQUAL(CCS811_BUS_NACK, fixture.sensor.get_last_error());
+    arduino_host_advance_ms(20);
+    CHECK(fixture.sensor.read(status));
+    CHECK(not status.firmware_is_in_application_mode);
+}
+
+TEST(simulator_heater_fault_reported_in_error_id) {
+    simulator_fixture fixture;
+    fixture.measure(CCS811_CONSTANT_POWER_1SEC);
+    uint32_t now_ms = millis();
+    const ccs811_simulator_fault_t faults[] = {{now_ms + 1000, 2000, CCS811_SIMULATOR_HEATER_FAULT, 0}};
+    fixture.simulator.set_fault_script(faults, 1);
+
+    ccs811_all_data_t data;
+    arduino_host_advance_ms(1000);
+    CHECK_EQUAL(CCS811_READ_NEW_DATA, fixture.sensor.read_new(data));
+    CHECK(data.status.error_has_occurred);
+    CHECK(data.error.heater_current_not_in_range);
+
+    ccs811_error_t error;
+    CHECK(fixture.sensor.read(error));  // Clears, but the next sample raises it again
+    arduino_host_advance_ms(1000);
+    CHECK_EQUAL(CCS811_READ_NEW_DATA, fixture.sensor.read_new(data));
+    CHECK(data.error.heater_current_not_in_range);
+
+    fixture.sensor.read(error);
+    arduino_host_advance_ms(1000);
+    CHECK_EQUAL(CCS811_READ_NEW_DATA, fixture.sensor.read_new(data));
+    CHECK(not data.status.error_has_occurred);
+}
+
+TEST(simulator_read_new_sees_every_sample_once_when_polled_fast) {
+    simulator_fixture fixture;
+    fixture.measure(CCS811_CONSTANT_POWER_250MS);
+
+    // Poll every 30 ms for a minute: each sample is read exactly once, and polls between samples leave data untouched
+    uint32_t new_samples = 0;
+    uint32_t mismatches = 0;
+    for (uint32_t poll = 0; poll < 2000; poll++) {
+        arduino_host_advance_ms(30);
+        ccs811_all_data_t data;
+        data.eCO2_ppb_reading.total = -1;
+        CCS811_READ_RESULT result = fixture.sensor.read_new(data);
+        if (result == CCS811_READ_NEW_DATA) {
+            new_samples++;
+            mismatches += data.eCO2_ppb_reading.total != fixture.simulator.get_eCO2();
+            mismatches += data.eTVOC_ppm_reading.total != fixture.simulator.get_eTVOC();
+            mismatches += fixture.sensor.get_sample_sequence() != new_samples;
+        } else {
+            mismatches += result != CCS811_READ_NO_NEW_DATA or data.eCO2_ppb_reading.total != -1;
+        }
+    }
+    ccs811_simulator_stats_t stats = fixture.simulator.get_stats();
+    CHECK_EQUAL(0, mismatches);
+    CHECK_EQUAL(stats.samples, new_samples);
+    CHECK_EQUAL(60000 / 250, new_samples);
+    CHECK_EQUAL(0, stats.overwritten_samples);
+}
@@ -0,0 +1,328 @@
+#include <stdlib.h>
+#include <string.h>
+#include "CCS811_statistics.h"
+#include "test.h"
+
+static const uint8_t SEGMENT_BLOCKS = 6;
+static const uint32_t HOUR_MS = 3600000;
+
+/**
+ * Fill whole blocks with samples every `period_ms`, eCO2 following a sawtooth between 400 and 1399 ppm.
+ * @param gap_after: Sample index after which the timestamps jump forward by an hour, or 0 for none.
+ * @return Number of samples written.
+ */
+static uint32_t make_segment(uint8_t* segment, uint8_t blocks, uint32_t period_ms, uint32_t gap_after = 0) {
+    uint32_t written = 0;
+    uint32_t time_ms = 0;
+    for (uint8_t b = 0; b < blocks; b++) {
+        CCS811BlockWriter writer(segment + b * CCS811_BLOCK_SIZE);
+        while (writer.append({time_ms, (uint16_t)(400 + written * 7 % 1000), (uint16_t)(written % 50)})) {
+            written++;
+            time_ms += period_ms;
+            if (written == gap_after) time_ms += HOUR_MS;
+        }
+        writer.finish();
+    }
+    return written;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// AGGREGATES
+
+TEST(aggregate_tracks_count_mean_extremes_and_time_above) {
+    CCS811Aggregate aggregate;
+    aggregate.add(500, 0, 1000);
+    aggregate.add(1500, 1000, 1000);
+    aggregate.add(1000, 1000, 1000);
+    aggregate.add(700, 1000, 1000);
+    CHECK_EQUAL(4, aggregate.get_count());
+    CHECK_NEAR(925, aggregate.get_mean(), 1e-3);
+    CHECK_EQUAL(500, aggregate.get_min());
+    CHECK_EQUAL(1500, aggregate.get_max());
+    CHECK_EQUAL(2000, aggregate.get_time_above_ms());
+
+    CCS811Aggregate other;
+    other.add(300, 1000, 1000);
+    aggregate.merge(other);
+    CHECK_EQUAL(5, aggregate.get_count());
+    CHECK_EQUAL(300, aggregate.get_min());
+    CHECK_NEAR(800, aggregate.get_mean(), 1e-3);
+}
+
+TEST(aggregate_segment_matches_a_brute_force_pass) {
+    static uint8_t segment[SEGMENT_BLOCKS * CCS811_BLOCK_SIZE];
+    uint32_t written = make_segment(segment, SEGMENT_BLOCKS, 10000);
+
+    const size_t buckets = 4;
+    ccs811_aggregate_query_t query = {HOUR_MS / 2, HOUR_MS / 2, CCS811_FIELD_eCO2, 1000, 15000};
+    CCS811Aggregate aggregates[buckets];
+    CCS811SegmentReader reader(segment, sizeof(segment));
+    uint32_t aggregated = ccs811_aggregate_segment(reader, query, aggregates, buckets);
+
+    uint32_t expected_aggregated = 0;
+    for (size_t b = 0; b < buckets; b++) {
+        uint32_t count = 0;
+        uint64_t sum = 0;
+        uint32_t time_above_ms = 0;
+        for (uint32_t i = 0; i < written; i++) {
+            uint32_t time_ms = i * 10000;
+            if (time_ms < query.start_ms + b * query.bucket_ms or time_ms >= query.start_ms + (b + 1) * query.bucket_ms)
+                continue;
+            uint16_t eCO2 = 400 + i * 7 % 1000;
+            count++;
+            sum += eCO2;
+            if (eCO2 >= query.threshold) time_above_ms += 10000;
+        }
+        expected_aggregated += count;
+        CHECK_EQUAL(count, aggregates[b].get_count());
+        if (count) CHECK_NEAR((double)sum / count, aggregates[b].get_mean(), 1e-2);
+        CHECK_EQUAL(time_above_ms, aggregates[b].get_time_above_ms());
+    }
+    CHECK_EQUAL(expected_aggregated, aggregated);
+    CHECK(aggregated > 0);
+}
+
+TEST(aggregate_segment_does_not_credit_gaps) {
+    static uint8_t segment[SEGMENT_BLOCKS * CCS811_BLOCK_SIZE];
+    uint32_t written = make_segment(segment, 1, 1000, 50);
+
+    // Every sample above threshold: one interval per sample after the first, the gap capped at max_gap_ms
+    ccs811_aggregate_query_t query = {0, 2 * HOUR_MS, CCS811_FIELD_eCO2, 0, 1500};
+    CCS811Aggregate aggregate;
+    CCS811SegmentReader reader(segment, CCS811_BLOCK_SIZE);
+    ccs811_aggregate_segment(reader, query, &aggregate, 1);
+    CHECK_EQUAL(written, aggregate.get_count());
+    CHECK_EQUAL((written - 2) * 1000 + 1500, aggregate.get_time_above_ms());
+
+    query.max_gap_ms = 0;
+    aggregate.reset();
+    reader.rewind();
+    ccs811_aggregate_segment(reader, query, &aggregate, 1);
+    CHECK_EQUAL((written - 1) * 1000 + HOUR_MS, aggregate.get_time_above_ms());
+}
+
+TEST(aggregate_segment_restarts_intervals_after_a_skipped_block) {
+    static uint8_t segment[SEGMENT_BLOCKS * CCS811_BLOCK_SIZE];
+    make_segment(segment, SEGMENT_BLOCKS, 1000);
+    segment[2 * CCS811_BLOCK_SIZE + 100] ^= 0x01;
+
+    ccs811_aggregate_query_t query = {0, 10 * HOUR_MS, CCS811_FIELD_eCO2, 0, 0};
+    CCS811Aggregate aggregate;
+    CCS811SegmentReader reader(segment, sizeof(segment));
+    ccs811_aggregate_segment(reader, query, &aggregate, 1);
+
+    // The first sample, and the first after the corrupt block, have no interval
+    CHECK_EQUAL((aggregate.get_count() - 2) * 1000, aggregate.get_time_above_ms());
+}
+
+TEST(aggregate_segment_slices_merge_into_the_whole) {
+    static uint8_t segment[SEGMENT_BLOCKS * CCS811_BLOCK_SIZE];
+    make_segment(segment, SEGMENT_BLOCKS, 1000);
+    ccs811_aggregate_query_t query = {0, HOUR_MS, CCS811_FIELD_eCO2, 1000, 1500};
+
+    CCS811Aggregate whole;
+    CCS811SegmentReader reader(segment, sizeof(segment));
+    ccs811_aggregate_segment(reader, query, &whole, 1);
+
+    CCS811Aggregate first;
+    CCS811Aggregate second;
+    const size_t split = 2 * CCS811_BLOCK_SIZE;
+    CCS811SegmentReader first_reader(segment, split);
+    CCS811SegmentReader second_reader(segment + split, sizeof(segment) - split);
+    ccs811_aggregate_segment(first_reader, query, &first, 1);
+    ccs811_aggregate_segment(second_reader, query, &second, 1);
+    first.merge(second);
+
+    CHECK_EQUAL(whole.get_count(), first.get_count());
+    CHECK_NEAR(whole.get_mean(), first.get_mean(), 1e-3);
+    CHECK_EQUAL(whole.get_min(), first.get_min());
+    CHECK_EQUAL(whole.get_max(), first.get_max());
+    CHECK(whole.get_time_above_ms() - first.get_time_above_ms() <= 1000);
+}
+
+TEST(aggregate_segment_cuts_a_range_off_at_the_end_of_the_clock) {
+    static uint8_t segment[SEGMENT_BLOCKS * CCS811_BLOCK_SIZE];
+    uint32_t written = make_segment(segment, SEGMENT_BLOCKS, 1000);
+
+    // Two buckets of 2^31 ms from 1 s would end at 2^32 + 1 s, which wraps to 1 s and drops every sample
+    ccs811_aggregate_query_t query = {1000, 0x80000000, CCS811_FIELD_eCO2, 0, 0};
+    CCS811Aggregate aggregates[2];
+    CCS811SegmentReader reader(segment, sizeof(segment));
+    CHECK_EQUAL(written - 1, ccs811_aggregate_segment(reader, query, aggregates, 2));
+    CHECK_EQUAL(written - 1, aggregates[0].get_count());
+    CHECK_EQUAL(0, aggregates[1].get_count());
+
+    // Twice as many buckets as the clock can hold, ending at exactly 2^33 ms
+    query.bucket_ms = 0x10000000;
+    CCS811Aggregate more_aggregates[32];
+    reader.rewind();
+    CHECK_EQUAL(written - 1, ccs811_aggregate_segment(reader, query, more_aggregates, 32));
+    CHECK_EQUAL(written - 1, more_aggregates[0].get_count());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ROLLING WINDOWS
+
+template <uint16_t SIZE>
+static uint32_t rolling_window_mismatches(uint32_t values, uint32_t seed) {
+    CCS811RollingWindow<SIZE> window;
+    static uint16_t series[100000];
+    uint32_t random = seed;
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < values; i++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        // Runs of rising and falling values exercise the monotonic queues; repeats exercise ties
+        series[i] = i % 1000 < 500 ? (uint16_t)(i % 500 + random % 4) : (uint16_t)(random % 8192);
+        window.add(series[i]);
+
+        uint32_t first = i + 1 >= SIZE ? i + 1 - SIZE : 0;
+        uint64_t sum = 0;
+        uint16_t low = 0xFFFF;
+        uint16_t high = 0;
+        for (uint32_t j = first; j <= i; j++) {
+            sum += series[j];
+            low = series[j] < low ? series[j] : low;
+            high = series[j] > high ? series[j] : high;
+        }
+        uint32_t count = i + 1 - first;
+        float mean = (float)sum / count;
+        mismatches += window.get_count() != count or window.get_min() != low or window.get_max() != high or
+                      fabsf(window.get_mean() - mean) > 1e-3f * mean;
+    }
+    return mismatches;
+}
+
+TEST(rolling_window_matches_a_brute_force_rescan) {
+    CHECK_EQUAL(0, rolling_window_mismatches<1>(100000, 1));
+    CHECK_EQUAL(0, rolling_window_mismatches<15>(100000, 2));
+    CHECK_EQUAL(0, rolling_window_mismatches<240>(100000, 3));
+}
+
+TEST(rolling_window_resets_to_empty) {
+    CCS811RollingWindow<4> window;
+    CHECK_EQUAL(0, window.get_max());
+    const uint16_t values[] = {500, 900, 450, 700, 600};
+    for (uint16_t value : values) window.add(value);
+    CHECK(window.is_full());
+    CHECK_EQUAL(450, window.get_min());
+    CHECK_EQUAL(900, window.get_max());
+    CHECK_NEAR(662.5, window.get_mean(), 1e-3);
+
+    window.reset();
+    CHECK_EQUAL(0, window.get_count());
+    window.add(420);
+    CHECK_EQUAL(420, window.get_min());
+    CHECK_EQUAL(420, window.get_max());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// QUANTILES
+
+static int compare_values(const void* a, const void* b) {
+    return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+TEST(quantile_sketch_stays_within_its_relative_accuracy) {
+    static uint16_t values[50000];
+    CCS811QuantileSketch<128> sketch;
+    uint32_t random = 7;
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        // Mostly clean air with occasional long-tailed spikes, as in an occupied room
+        values[i] = random % 10 ? (uint16_t)(400 + random % 400) : (uint16_t)(400 + random % 7000);
+        sketch.add(values[i]);
+    }
+    qsort(values, sizeof(values) / sizeof(values[0]), sizeof(values[0]), compare_values);
+
+    float accuracy = sketch.get_relative_accuracy();
+    CHECK(accuracy < 0.036f);
+    const float quantiles[] = {0, 0.1f, 0.5f, 0.9f, 0.95f, 0.98f, 0.99f, 1};
+    for (float quantile : quantiles) {
+        uint16_t exact = values[(uint32_t)(quantile * (sketch.get_count() - 1))];
+        // Rounding the estimate to a whole ppm adds up to half a unit
+        CHECK_NEAR(exact, sketch.get_quantile(quantile), exact * accuracy + 0.5);
+    }
+}
+
+TEST(quantile_sketch_merges_exactly) {
+    CCS811QuantileSketch<128> whole;
+    CCS811QuantileSketch<128> first;
+    CCS811QuantileSketch<128> second;
+    for (uint16_t i = 0; i < 5000; i++) {
+        uint16_t value = 400 + i * 37 % 4000;
+        whole.add(value);
+        (i % 3 ? first : second).add(value);
+    }
+    first.merge(second);
+    CHECK_EQUAL(whole.get_count(), first.get_count());
+    for (uint8_t percent = 0; percent <= 100; percent++)
+        CHECK_EQUAL(whole.get_quantile(percent / 100.0f), first.get_quantile(percent / 100.0f));
+
+    CCS811QuantileSketch<128> empty;
+    CHECK_EQUAL(0, empty.get_quantile(0.5f));
+}
+
+TEST(aggregate_segment_tracks_quantiles_per_bucket) {
+    static uint8_t segment[SEGMENT_BLOCKS * CCS811_BLOCK_SIZE];
+    static uint16_t values[SEGMENT_BLOCKS * CCS811_BLOCK_SIZE];
+    uint32_t written = make_segment(segment, SEGMENT_BLOCKS, 10000);
+
+    const size_t buckets = 4;
+    ccs811_aggregate_query_t query = {HOUR_MS / 2, HOUR_MS / 2, CCS811_FIELD_eCO2, 1000, 15000};
+    CCS811Aggregate aggregates[buckets];
+    CCS811AggregateSketch sketches[buckets];
+    for (size_t b = 0; b < buckets; b++) aggregates[b].set_sketch(&sketches[b]);
+    CCS811SegmentReader reader(segment, sizeof(segment));
+    ccs811_aggregate_segment(reader, query, aggregates, buckets);
+
+    float accuracy = sketches[0].get_relative_accuracy();
+    for (size_t b = 0; b < buckets; b++) {
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < written; i++) {
+            uint32_t time_ms = i * 10000;
+            uint32_t bucket_start_ms = query.start_ms + b * query.bucket_ms;
+            if (time_ms < bucket_start_ms or time_ms >= bucket_start_ms + query.bucket_ms) continue;
+            values[count++] = 400 + i * 7 % 1000;
+        }
+        CHECK_EQUAL(count, sketches[b].get_count());
+        if (count == 0) continue;
+        qsort(values, count, sizeof(values[0]), compare_values);
+        const float quantiles[] = {0.5f, 0.95f};
+        for (float quantile : quantiles) {
+            uint16_t exact = values[(uint32_t)(quantile * (count - 1))];
+            CHECK_NEAR(exact, aggregates[b].get_quantile(quantile), exact * accuracy + 0.5);
+        }
+    }
+
+    // Slices with their own sketches merge into the quantiles of the whole
+    CCS811Aggregate whole;
+    CCS811Aggregate first;
+    CCS811Aggregate second;
+    CCS811AggregateSketch whole_sketch;
+    CCS811AggregateSketch first_sketch;
+    CCS811AggregateSketch second_sketch;
+    whole.set_sketch(&whole_sketch);
+    first.set_sketch(&first_sketch);
+    second.set_sketch(&second_sketch);
+    query.bucket_ms = 10 * HOUR_MS;
+    reader.rewind();
+    ccs811_aggregate_segment(reader, query, &whole, 1);
+    const size_t split = 3 * CCS811_BLOCK_SIZE;
+    CCS811SegmentReader first_reader(segment, split);
+    CCS811SegmentReader second_reader(segment + split, sizeof(segment) - split);
+    ccs811_aggregate_segment(first_reader, query, &first, 1);
+    ccs811_aggregate_segment(second_reader, query, &second, 1);
+    first.merge(second);
+    CHECK_EQUAL(whole_sketch.get_count(), first_sketch.get_count());
+    for (uint8_t percent = 0; percent <= 100; percent += 5)
+        CHECK_EQUAL(whole.get_quantile(percent / 100.0f), first.get_quantile(percent / 100.0f));
+
+    // Without a sketch there are no quantiles; reset empties the sketch along with the aggregate
+    CHECK_EQUAL(0, CCS811Aggregate().get_quantile(0.5f));
+    whole.reset();
+    CHECK_EQUAL(0, whole_sketch.get_count());
+}
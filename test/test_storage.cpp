@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "CCS811_segment_file.h"
+#include "CCS811_storage.h"
+#include "test.h"
+
+static const uint8_t SEGMENT_BLOCKS = 8;
+
+/**
+ * A segment of full blocks holding consecutive 1 s samples, with eCO2 stepping by one per sample.
+ * @return Number of samples written.
+ */
+static uint32_t make_segment(uint8_t* segment, uint8_t blocks) {
+    uint32_t written = 0;
+    for (uint8_t b = 0; b < blocks; b++) {
+        CCS811BlockWriter writer(segment + b * CCS811_BLOCK_SIZE);
+        while (true) {
+            ccs811_sample_t sample = {1000 * written, (uint16_t)(400 + written % 1000), (uint16_t)(written % 100)};
+            if (not writer.append(sample)) break;
+            written++;
+        }
+        writer.finish();
+    }
+    return written;
+}
+
+static ccs811_block_header_t header_of(const uint8_t* block) {
+    ccs811_block_header_t header;
+    memcpy(&header, block, sizeof(header));
+    return header;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(crc32_matches_the_check_value) {
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    CHECK_EQUAL(0xCBF43926, ccs811_crc32(check, sizeof(check)));
+    CHECK_EQUAL(0, ccs811_crc32(check, 0));
+    CHECK_EQUAL(0xCBF43926, ccs811_crc32(check + 4, 5, ccs811_crc32(check, 4)));
+}
+
+TEST(block_header_indexes_its_samples) {
+    uint8_t block[CCS811_BLOCK_SIZE];
+    CCS811BlockWriter writer(block);
+    const ccs811_sample_t samples[] = {{1000, 450, 20}, {2000, 900, 5}, {3010, 420, 60}};
+    for (const ccs811_sample_t& sample : samples) CHECK(writer.append(sample));
+    writer.finish();
+
+    CHECK(ccs811_block_is_valid(block));
+    ccs811_block_header_t header = header_of(block);
+    CHECK_EQUAL(3, header.sample_count);
+    CHECK_EQUAL(1000, header.start_time_ms);
+    CHECK_EQUAL(3010, header.end_time_ms);
+    CHECK_EQUAL(420, header.min_eCO2);
+    CHECK_EQUAL(900, header.max_eCO2);
+    CHECK_EQUAL(5, header.min_eTVOC);
+    CHECK_EQUAL(60, header.max_eTVOC);
+    CHECK(ccs811_block_may_exceed(header, 900, 1000));
+    CHECK(not ccs811_block_may_exceed(header, 901, 61));
+}
+
+TEST(segment_reads_back_every_sample) {
+    static uint8_t segment[SEGMENT_BLOCKS * CCS811_BLOCK_SIZE];
+    uint32_t written = make_segment(segment, SEGMENT_BLOCKS);
+    CHECK(written > SEGMENT_BLOCKS * 100);
+
+    CCS811SegmentReader reader(segment, sizeof(segment));
+    ccs811_block_header_t header;
+    uint32_t read = 0;
+    uint32_t mismatches = 0;
+    while (reader.next_block(header)) {
+        CCS811SampleDecoder decoder = reader.decode_block();
+        ccs811_sample_t sample;
+        while (decoder.next(sample)) {
+            mismatches += sample.time_ms != 1000 * read or sample.eCO2 != 400 + read % 1000;
+            read++;
+        }
+    }
+    CHECK_EQUAL(written, read);
+    CHECK_EQUAL(0, mismatches);
+}
+
+TEST(segment_skips_a_corrupt_block) {
+    static uint8_t segment[SEGMENT_BLOCKS * CCS811_BLOCK_SIZE];
+    make_segment(segment, SEGMENT_BLOCKS);
+    segment[3 * CCS811_BLOCK_SIZE + 100] ^= 0x01;
+    CHECK(not ccs811_block_is_valid(segment + 3 * CCS811_BLOCK_SIZE));
+
+    CCS811SegmentReader reader(segment, sizeof(segment));
+    ccs811_block_header_t header;
+    uint8_t blocks = 0;
+    while (reader.next_block(header)) {
+        CHECK(header.start_time_ms != header_of(segment + 3 * CCS811_BLOCK_SIZE).start_time_ms);
+        blocks++;
+    }
+    CHECK_EQUAL(SEGMENT_BLOCKS - 1, blocks);
+}
+
+TEST(segment_range_query_returns_overlapping_blocks_only) {
+    static uint8_t segment[SEGMENT_BLOCKS * CCS811_BLOCK_SIZE];
+    make_segment(segment, SEGMENT_BLOCKS);
+    ccs811_block_header_t third = header_of(segment + 2 * CCS811_BLOCK_SIZE);
+    ccs811_block_header_t fourth = header_of(segment + 3 * CCS811_BLOCK_SIZE);
+
+    // From the last sample of the third block up to, not including, the first sample of the fifth
+    uint32_t start_ms = third.end_time_ms;
+    uint32_t end_ms = fourth.end_time_ms + 1000;
+    CCS811SegmentReader reader(segment, sizeof(segment));
+    ccs811_block_header_t header;
+    CHECK(reader.next_block(header, start_ms, end_ms));
+    CHECK_EQUAL(third.start_time_ms, header.start_time_ms);
+    CHECK(reader.next_block(header, start_ms, end_ms));
+    CHECK_EQUAL(fourth.start_time_ms, header.start_time_ms);
+    CHECK(not reader.next_block(header, start_ms, end_ms));
+
+    reader.rewind();
+    CHECK(not reader.next_block(header, 0xF0000000, 0xF0001000));
+}
+
+TEST(segment_waits_for_a_block_still_being_written) {
+    static uint8_t complete[SEGMENT_BLOCKS * CCS811_BLOCK_SIZE];
+    static uint8_t segment[SEGMENT_BLOCKS * CCS811_BLOCK_SIZE];
+    make_segment(complete, SEGMENT_BLOCKS);
+
+    // Three blocks stored, the fourth half written, and the fifth not started
+    memset(segment, 0xFF, sizeof(segment));
+    memcpy(segment, complete, 3 * CCS811_BLOCK_SIZE + CCS811_BLOCK_SIZE / 2);
+    CCS811SegmentReader reader(segment, 4 * CCS811_BLOCK_SIZE);
+    ccs811_block_header_t header;
+    uint8_t blocks = 0;
+    while (reader.next_block(header)) blocks++;
+    CHECK_EQUAL(3, blocks);
+    CHECK(not reader.next_block(header));
+
+    // The fourth block completes and the fifth is half written
+    memcpy(segment, complete, 4 * CCS811_BLOCK_SIZE + CCS811_BLOCK_SIZE / 2);
+    reader.extend(5 * CCS811_BLOCK_SIZE);
+    CHECK(reader.next_block(header));
+    CHECK_EQUAL(header_of(complete + 3 * CCS811_BLOCK_SIZE).start_time_ms, header.start_time_ms);
+    CHECK(not reader.next_block(header));
+
+    // The fifth completes; a range query sees it as well
+    memcpy(segment, complete, 5 * CCS811_BLOCK_SIZE);
+    ccs811_block_header_t fifth = header_of(complete + 4 * CCS811_BLOCK_SIZE);
+    CHECK(reader.next_block(header, fifth.start_time_ms, fifth.end_time_ms + 1));
+    CHECK_EQUAL(fifth.start_time_ms, header.start_time_ms);
+}
+
+TEST(segment_file_is_mapped_and_followed_as_it_grows) {
+    static uint8_t complete[SEGMENT_BLOCKS * CCS811_BLOCK_SIZE];
+    uint32_t written = make_segment(complete, SEGMENT_BLOCKS);
+
+    char path[] = "/tmp/ccs811_segment_XXXXXX";
+    int descriptor = mkstemp(path);
+    CHECK(descriptor >= 0);
+    close(descriptor);
+
+    // Three blocks stored and the fourth half written
+    size_t stored = 3 * CCS811_BLOCK_SIZE + CCS811_BLOCK_SIZE / 2;
+    FILE* file = fopen(path, "wb");
+    CHECK(fwrite(complete, 1, stored, file) == stored);
+    fflush(file);
+
+    CCS811SegmentFile segment;
+    CHECK(segment.open(path));
+    CHECK_EQUAL(stored, segment.get_size());
+    CCS811SegmentReader reader(segment.get_data(), segment.get_size());
+    ccs811_block_header_t header;
+    ccs811_sample_t sample;
+    uint32_t blocks = 0;
+    uint32_t decoded = 0;
+    while (reader.next_block(header)) {
+        blocks++;
+        CCS811SampleDecoder decoder = reader.decode_block();
+        while (decoder.next(sample)) CHECK_EQUAL(1000 * decoded++, sample.time_ms);
+    }
+    CHECK_EQUAL(3, blocks);
+    CHECK(not segment.refresh(reader));
+
+    // The writer finishes the segment; the file is remapped and the reader carries on where it stopped
+    CHECK(fwrite(complete + stored, 1, sizeof(complete) - stored, file) == sizeof(complete) - stored);
+    fclose(file);
+    CHECK(segment.refresh(reader));
+    CHECK_EQUAL(sizeof(complete), segment.get_size());
+    CHECK_EQUAL(1, segment.get_remaps());
+    while (reader.next_block(header)) {
+        blocks++;
+        CCS811SampleDecoder decoder = reader.decode_block();
+        while (decoder.next(sample)) CHECK_EQUAL(1000 * decoded++, sample.time_ms);
+    }
+    CHECK_EQUAL(SEGMENT_BLOCKS, blocks);
+    CHECK_EQUAL(written, decoded);
+
+    segment.close();
+    CHECK(not segment.open("/nonexistent/ccs811_segment"));
+    remove(path);
+}
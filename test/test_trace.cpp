@@ -0,0 +1,286 @@
+#include <Arduino.h>
+#include <MockTwoWireDevice.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "CCS811_driver.h"
+#include "CCS811_simulator.h"
+#include "CCS811_trace.h"
+#include "test.h"
+
+static const uint8_t ALG_RESULT_DATA = 0x02;
+static const uint8_t MEAS_MODE = 0x01;
+static const uint8_t HW_ID = 0x20;
+
+static const size_t TRACE_CAPACITY = 16384;
+static const uint8_t SESSION_POLLS = 30;
+
+static ccs811_trace_record_t record_at(const uint8_t* trace, size_t offset) {
+    ccs811_trace_record_t record;
+    memcpy(&record, trace + offset, sizeof(record));
+    return record;
+}
+
+/**
+ * A short acquisition session: start measuring, then poll once a second and keep every new eCO2 value.
+ * @return Number of samples read.
+ */
+static uint8_t run_session(CCS811& sensor, TwoWire& bus, uint16_t* eCO2) {
+    uint8_t samples = 0;
+    if (not sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus)) return 0;
+    sensor.start_application_mode();
+    ccs811_measure_config_t config;
+    config.raw = 0;
+    config.drive_mode = CCS811_CONSTANT_POWER_1SEC;
+    sensor.write(config);
+    sensor.write_environmental_data(22.5, 40.0);
+
+    for (uint8_t poll = 0; poll < SESSION_POLLS; poll++) {
+        arduino_host_advance_ms(1000);
+        ccs811_all_data_t data;
+        if (sensor.read_new(data) == CCS811_READ_NEW_DATA) eCO2[samples++] = data.eCO2_ppb_reading.total;
+    }
+    return samples;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(trace_records_each_transaction_with_its_payload) {
+    TwoWire bus;
+    MockTwoWireDevice device;
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &device);
+    device.set_register(HW_ID, CCS811_HARDWARE_ID);
+    const uint8_t result[] = {0x01, 0x90, 0x00, 0x05, 0x98, 0x00, 0x12, 0x34};
+    device.set_register(ALG_RESULT_DATA, result, sizeof(result));
+
+    CCS811 sensor;
+    CCS811TraceRecorder recorder(TRACE_CAPACITY);
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);
+    recorder.start(sensor);
+    ccs811_all_data_t data;
+    CHECK(sensor.read(data));
+    recorder.stop(sensor);
+
+    CHECK_EQUAL(1, recorder.get_records());
+    CHECK_EQUAL(CCS811_TRACE_RECORD_SIZE + sizeof(result), recorder.get_size());
+    ccs811_trace_record_t record = record_at(recorder.get_trace(), 0);
+    CHECK_EQUAL(CCS811_DEFAULT_I2C_ADDRESS, record.device_address);
+    CHECK_EQUAL(ALG_RESULT_DATA, record.reg);
+    CHECK_EQUAL(CCS811_TRACE_READ, record.direction);
+    CHECK_EQUAL(sizeof(result), record.length);
+    CHECK_EQUAL(CCS811_BUS_OK, record.result);
+    CHECK_EQUAL(millis(), record.time_ms);
+    CHECK(memcmp(recorder.get_trace() + CCS811_TRACE_RECORD_SIZE, result, sizeof(result)) == 0);
+}
+
+TEST(trace_recorders_run_side_by_side_and_tag_each_sensor) {
+    TwoWire bus;
+    MockTwoWireDevice first_device;
+    MockTwoWireDevice second_device;
+    const uint8_t second_address = CCS811_DEFAULT_I2C_ADDRESS + 1;
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &first_device);
+    bus.attach(second_address, &second_device);
+    first_device.set_register(HW_ID, CCS811_HARDWARE_ID);
+    second_device.set_register(HW_ID, CCS811_HARDWARE_ID);
+
+    CCS811 first;
+    CCS811 second;
+    CCS811TraceRecorder own(TRACE_CAPACITY);
+    CCS811TraceRecorder shared(TRACE_CAPACITY);
+    own.start(first);
+    shared.start(second);
+    CHECK(first.begin(CCS811_DEFAULT_I2C_ADDRESS, bus));
+    CHECK(second.begin(second_address, bus));
+    shared.start(first);
+    CHECK(first.comms_check());
+    own.stop(first);
+    shared.stop(second);
+
+    CHECK_EQUAL(1, own.get_records());
+    CHECK_EQUAL(CCS811_DEFAULT_I2C_ADDRESS, record_at(own.get_trace(), 0).device_address);
+    CHECK_EQUAL(2, shared.get_records());
+    CHECK_EQUAL(second_address, record_at(shared.get_trace(), 0).device_address);
+    CHECK_EQUAL(CCS811_DEFAULT_I2C_ADDRESS, record_at(shared.get_trace(), CCS811_TRACE_RECORD_SIZE + 1).device_address);
+}
+
+TEST(trace_reports_no_payload_for_a_nacked_write) {
+    TwoWire bus;
+    MockTwoWireDevice device;
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &device);
+    device.set_register(HW_ID, CCS811_HARDWARE_ID);
+
+    CCS811 sensor;
+    CCS811TraceRecorder recorder(TRACE_CAPACITY);
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);
+    recorder.start(sensor);
+    device.fail_next_transactions(1);
+    ccs811_measure_config_t config;
+    config.raw = 0x10;
+    CHECK(not sensor.write(config));
+    recorder.stop(sensor);
+
+    CHECK_EQUAL(CCS811_TRACE_RECORD_SIZE, recorder.get_size());
+    ccs811_trace_record_t record = record_at(recorder.get_trace(), 0);
+    CHECK_EQUAL(MEAS_MODE, record.reg);
+    CHECK_EQUAL(CCS811_TRACE_WRITE, record.direction);
+    CHECK_EQUAL(0, record.length);
+    CHECK_EQUAL(CCS811_BUS_NACK, record.result);
+}
+
+TEST(trace_keeps_short_read_retries_apart) {
+    TwoWire bus;
+    MockTwoWireDevice device;
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &device);
+    device.set_register(HW_ID, CCS811_HARDWARE_ID);
+
+    CCS811 sensor;
+    CCS811TraceRecorder recorder(TRACE_CAPACITY);
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);
+    sensor.set_short_read_retries(1);
+    recorder.start(sensor);
+    device.shorten_next_reads(1, 3);
+    ccs811_all_data_t data;
+    CHECK(sensor.read(data));
+    recorder.stop(sensor);
+
+    CHECK_EQUAL(2, recorder.get_records());
+    ccs811_trace_record_t first = record_at(recorder.get_trace(), 0);
+    CHECK_EQUAL(3, first.length);
+    CHECK_EQUAL(CCS811_BUS_SHORT_READ, first.result);
+    ccs811_trace_record_t second = record_at(recorder.get_trace(), CCS811_TRACE_RECORD_SIZE + 3);
+    CHECK_EQUAL(8, second.length);
+    CHECK_EQUAL(CCS811_BUS_OK, second.result);
+}
+
+TEST(trace_recorder_drops_what_does_not_fit) {
+    TwoWire bus;
+    MockTwoWireDevice device;
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &device);
+    device.set_register(HW_ID, CCS811_HARDWARE_ID);
+
+    CCS811 sensor;
+    CCS811TraceRecorder recorder(2 * (CCS811_TRACE_RECORD_SIZE + 8));
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);
+    recorder.start(sensor);
+    ccs811_all_data_t data;
+    for (uint8_t i = 0; i < 3; i++) sensor.read(data);
+    recorder.stop(sensor);
+
+    CHECK_EQUAL(2, recorder.get_records());
+    CHECK_EQUAL(1, recorder.get_dropped());
+}
+
+TEST(trace_replay_reproduces_a_session) {
+    uint16_t recorded[SESSION_POLLS];
+    uint8_t recorded_samples;
+    CCS811TraceRecorder recorder(TRACE_CAPACITY);
+    {
+        TwoWire bus;
+        ccs811_simulator_config_t config = CCS811_DEFAULT_SIMULATOR_CONFIG;
+        config.walk_step = 50;
+        config.period_scale = 0.98f;
+        CCS811Simulator simulator(config);
+        bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &simulator);
+        CCS811 sensor;
+        recorder.start(sensor);
+        recorded_samples = run_session(sensor, bus, recorded);
+        recorder.stop(sensor);
+    }
+    CHECK(recorded_samples >= SESSION_POLLS - 1);
+    CHECK_EQUAL(0, recorder.get_dropped());
+
+    TwoWire bus;
+    CCS811TraceReplay replay(recorder.get_trace(), recorder.get_size());
+    replay.set_follow_time(true);
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &replay);
+    CCS811 sensor;
+    uint16_t replayed[SESSION_POLLS];
+    uint8_t replayed_samples = run_session(sensor, bus, replayed);
+
+    CHECK_EQUAL(recorded_samples, replayed_samples);
+    CHECK(memcmp(recorded, replayed, recorded_samples * sizeof(uint16_t)) == 0);
+    CHECK_EQUAL(recorder.get_records(), replay.get_stats().transactions);
+    CHECK_EQUAL(0, replay.get_stats().mismatches);
+    CHECK(replay.is_finished());
+}
+
+TEST(trace_replay_follows_recorded_time) {
+    // Two status reads recorded 250 ms apart
+    uint8_t trace[2 * (CCS811_TRACE_RECORD_SIZE + 1)];
+    ccs811_trace_record_t record = {1000, CCS811_DEFAULT_I2C_ADDRESS, 0x00, 1, CCS811_TRACE_READ, CCS811_BUS_OK};
+    memcpy(trace, &record, sizeof(record));
+    trace[CCS811_TRACE_RECORD_SIZE] = 0x90;
+    record.time_ms = 1250;
+    memcpy(trace + CCS811_TRACE_RECORD_SIZE + 1, &record, sizeof(record));
+    trace[2 * CCS811_TRACE_RECORD_SIZE + 1] = 0x98;
+
+    TwoWire bus;
+    CCS811TraceReplay replay(trace, sizeof(trace));
+    replay.set_follow_time(true);
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &replay);
+    CCS811 sensor;
+    sensor.set_comms_retry_policy(0, 0);
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);  // Fails: the trace starts with a status read, not the ID check
+
+    CHECK_EQUAL(1, replay.get_stats().mismatches);
+    ccs811_status_t status;
+    uint32_t start_ms = millis();
+    CHECK(sensor.read(status));
+    CHECK(not status.data_ready);
+    CHECK_EQUAL(start_ms, millis());
+    CHECK(sensor.read(status));
+    CHECK(status.data_ready);
+    CHECK_EQUAL(start_ms + 250, millis());
+    CHECK(replay.is_finished());
+}
+
+TEST(trace_replay_fails_transactions_that_diverge) {
+    uint8_t trace[CCS811_TRACE_RECORD_SIZE + 1];
+    ccs811_trace_record_t record = {0, CCS811_DEFAULT_I2C_ADDRESS, HW_ID, 1, CCS811_TRACE_READ, CCS811_BUS_OK};
+    memcpy(trace, &record, sizeof(record));
+    trace[CCS811_TRACE_RECORD_SIZE] = CCS811_HARDWARE_ID;
+
+    TwoWire bus;
+    CCS811TraceReplay replay(trace, sizeof(trace));
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &replay);
+    CCS811 sensor;
+    sensor.set_comms_retry_policy(0, 0);
+    CHECK(sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus));
+    CHECK(replay.is_finished());
+
+    ccs811_status_t status;
+    CHECK(not sensor.read(status));
+    CHECK_EQUAL(1, replay.get_stats().mismatches);
+
+    replay.set_loop(true);
+    CHECK(sensor.comms_check());
+    CHECK_EQUAL(1, replay.get_stats().rewinds);
+}
+
+TEST(trace_round_trips_through_a_file) {
+    TwoWire bus;
+    MockTwoWireDevice device;
+    bus.attach(CCS811_DEFAULT_I2C_ADDRESS, &device);
+    device.set_register(HW_ID, CCS811_HARDWARE_ID);
+
+    CCS811 sensor;
+    CCS811TraceRecorder recorder(TRACE_CAPACITY);
+    recorder.start(sensor);
+    sensor.begin(CCS811_DEFAULT_I2C_ADDRESS, bus);
+    sensor.write_co2_thresholds(1500, 2500);
+    recorder.stop(sensor);
+
+    char path[] = "/tmp/ccs811_trace_XXXXXX";
+    int descriptor = mkstemp(path);
+    CHECK(descriptor >= 0);
+    close(descriptor);
+    CHECK(recorder.save(path));
+
+    uint8_t loaded[TRACE_CAPACITY];
+    size_t size = 0;
+    CHECK(ccs811_trace_load(path, loaded, sizeof(loaded), size));
+    CHECK_EQUAL(recorder.get_size(), size);
+    CHECK(memcmp(loaded, recorder.get_trace(), size) == 0);
+    CHECK(not ccs811_trace_load(path, loaded, size - 1, size));
+    remove(path);
+}